@@ -5,7 +5,8 @@ endfunction()
 
 function(add_catch TARGET)
     add_executable_with_include(${TARGET} ${ARGN})
-    target_link_libraries(${TARGET} contrib_catch_main)
+    target_link_libraries(${TARGET} contrib_catch_main Threads::Threads)
+    add_test(NAME ${TARGET} COMMAND ${TARGET})
 
     if (TEST_SOLUTION)
         add_custom_target(
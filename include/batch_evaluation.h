@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "simd.h"
+
+namespace SingleVariable {
+
+// Polynomial prepared for Horner's rule: coefs from the highest degree down, gaps[k] is
+// the degree difference between coefs[k] and the next term (or the lowest degree for
+// the last one)
+template <typename W>
+struct HornerProgram {
+    std::vector<W> coefs;
+    std::vector<size_t> gaps;
+};
+
+// Types evaluated lane-parallel. Integers wrap, so they are computed as unsigned.
+template <typename T>
+inline constexpr bool kBatchEvaluated =
+    std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, int32_t> ||
+    std::is_same_v<T, int64_t> || std::is_same_v<T, uint32_t> || std::is_same_v<T, uint64_t>;
+
+template <typename T>
+using BatchWorkType =
+    typename std::conditional_t<std::is_integral_v<T>, std::make_unsigned<T>,
+                                std::type_identity<T>>::type;
+
+// Portable kernel: kLanes independent points per step with fixed trip count inner
+// loops, which the compiler turns into SSE2/NEON code
+template <typename W>
+void HornerLanes(const HornerProgram<W>& program, const W* points, W* out, size_t count) {
+    constexpr size_t kLanes = 64 / sizeof(W);
+    auto run = [&program](const W* x, W* acc, auto lanes) {
+        constexpr size_t kCount = decltype(lanes)::value;
+        auto multiply_by_power = [](W* values, const W* base, size_t gap) {
+            W square[kCount];
+            for (size_t lane = 0; lane < kCount; ++lane) {
+                square[lane] = base[lane];
+            }
+            while (true) {
+                if (gap & 1) {
+                    for (size_t lane = 0; lane < kCount; ++lane) {
+                        values[lane] *= square[lane];
+                    }
+                }
+                gap >>= 1;
+                if (gap == 0) {
+                    break;
+                }
+                for (size_t lane = 0; lane < kCount; ++lane) {
+                    square[lane] *= square[lane];
+                }
+            }
+        };
+        for (size_t lane = 0; lane < kCount; ++lane) {
+            acc[lane] = program.coefs[0];
+        }
+        for (size_t k = 1; k < program.coefs.size(); ++k) {
+            W coef = program.coefs[k];
+            if (program.gaps[k - 1] == 1) {
+                for (size_t lane = 0; lane < kCount; ++lane) {
+                    acc[lane] = acc[lane] * x[lane] + coef;
+                }
+            } else {
+                multiply_by_power(acc, x, program.gaps[k - 1]);
+                for (size_t lane = 0; lane < kCount; ++lane) {
+                    acc[lane] += coef;
+                }
+            }
+        }
+        if (program.gaps.back() != 0) {
+            multiply_by_power(acc, x, program.gaps.back());
+        }
+    };
+    size_t i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        run(points + i, out + i, std::integral_constant<size_t, kLanes>{});
+    }
+    for (; i < count; ++i) {
+        run(points + i, out + i, std::integral_constant<size_t, 1>{});
+    }
+}
+
+#ifdef POLYNOMIAL_X86_DISPATCH
+
+template <typename Vec, typename W>
+POLYNOMIAL_AVX2 typename Vec::Type PowerAvx2(typename Vec::Type base, size_t gap) {
+    typename Vec::Type res = Vec::Broadcast(W(1));
+    while (gap != 0) {
+        if (gap & 1) {
+            res = Vec::Multiply(res, base);
+        }
+        base = Vec::Multiply(base, base);
+        gap >>= 1;
+    }
+    return res;
+}
+
+// Two independent vectors per step hide the latency of the dependent Horner chain
+template <typename Vec, typename W>
+POLYNOMIAL_AVX2 void HornerAvx2(const HornerProgram<W>& program, const W* points, W* out,
+                                size_t count) {
+    constexpr size_t kWidth = Vec::kWidth;
+    size_t i = 0;
+    for (; i + 2 * kWidth <= count; i += 2 * kWidth) {
+        auto x0 = Vec::Load(points + i);
+        auto x1 = Vec::Load(points + i + kWidth);
+        auto acc0 = Vec::Broadcast(program.coefs[0]);
+        auto acc1 = acc0;
+        for (size_t k = 1; k < program.coefs.size(); ++k) {
+            auto coef = Vec::Broadcast(program.coefs[k]);
+            size_t gap = program.gaps[k - 1];
+            if (gap == 1) {
+                acc0 = Vec::MulAdd(acc0, x0, coef);
+                acc1 = Vec::MulAdd(acc1, x1, coef);
+            } else {
+                acc0 = Vec::MulAdd(acc0, PowerAvx2<Vec, W>(x0, gap), coef);
+                acc1 = Vec::MulAdd(acc1, PowerAvx2<Vec, W>(x1, gap), coef);
+            }
+        }
+        if (program.gaps.back() != 0) {
+            acc0 = Vec::Multiply(acc0, PowerAvx2<Vec, W>(x0, program.gaps.back()));
+            acc1 = Vec::Multiply(acc1, PowerAvx2<Vec, W>(x1, program.gaps.back()));
+        }
+        Vec::Store(out + i, acc0);
+        Vec::Store(out + i + kWidth, acc1);
+    }
+    HornerLanes(program, points + i, out + i, count - i);
+}
+
+#endif
+
+// Floating-point results may differ from operator() in the last bits when the fused
+// multiply-add path is taken
+template <typename W>
+void EvaluateBatch(const HornerProgram<W>& program, const W* points, W* out, size_t count) {
+    if (program.coefs.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = W(0);
+        }
+        return;
+    }
+#ifdef POLYNOMIAL_X86_DISPATCH
+    if (HasAvx2Fma()) {
+        if constexpr (std::is_same_v<W, double>) {
+            HornerAvx2<Avx2Double>(program, points, out, count);
+            return;
+        } else if constexpr (std::is_same_v<W, float>) {
+            HornerAvx2<Avx2Float>(program, points, out, count);
+            return;
+        } else if constexpr (std::is_same_v<W, uint32_t>) {
+            HornerAvx2<Avx2Uint32>(program, points, out, count);
+            return;
+        }
+    }
+#endif
+    HornerLanes(program, points, out, count);
+}
+
+}  // namespace SingleVariable
@@ -3,6 +3,28 @@
 #include <any>
 #include <type_traits>
 
+// Constants shaped like an example value, such as a zero matrix of the example's size.
+// Types that need more than T(value) specialize ring_traits with
+//   const_like(example, value) - value converted to the type of example, where 1 is the
+//                                multiplicative identity
+//   is_zero(x)                 - whether x equals const_like(x, 0), without building it
+// and may add
+//   lazy_one(example)          - a cheaper stand-in for the identity shaped like example
+//                                that multiplies with scalars and adds to the type
+//   lazy_zero(example)         - the same for zero, also converting to the type
+// Everything is resolved at compile time.
+template <typename T>
+struct ring_traits {
+    static T const_like(const T&, int value) {
+        return T(value);
+    }
+
+    static bool is_zero(const T& x) {
+        return x == T(0);
+    }
+};
+
+// Runtime description of a shape for types that predate ring_traits
 struct DefaultParams {
     std::any data;
 };
@@ -12,13 +34,22 @@ public:
     virtual struct DefaultParams GetDefaultParams() const = 0;
 };
 
+// Adapter for ComplexType: T(example.GetDefaultParams(), value) as before
 template <typename T>
-T GetConst(const T& value, int cnst) {
-    if constexpr (std::is_base_of_v<ComplexType, T>) {
-        return T(value.GetDefaultParams(), cnst);
-    } else {
-        return T(cnst);
+    requires std::is_base_of_v<ComplexType, T>
+struct ring_traits<T> {
+    static T const_like(const T& example, int value) {
+        return T(example.GetDefaultParams(), value);
+    }
+
+    static bool is_zero(const T& x) {
+        return x == const_like(x, 0);
     }
+};
+
+template <typename T>
+T GetConst(const T& value, int cnst) {
+    return ring_traits<T>::const_like(value, cnst);
 }
 
 template <typename T>
@@ -30,3 +61,32 @@ template <typename T>
 T GetOne(const T& value) {
     return GetConst(value, 1);
 }
+
+template <typename T>
+bool IsZero(const T& value) {
+    return ring_traits<T>::is_zero(value);
+}
+
+// Multiplicative identity for accumulations like res += c * one, where a symbolic
+// identity saves building the full one, as ScaledIdentity does for matrices. Falls back
+// to GetOne for types without ring_traits<T>::lazy_one.
+template <typename T>
+auto GetLazyOne(const T& value) {
+    if constexpr (requires { ring_traits<T>::lazy_one(value); }) {
+        return ring_traits<T>::lazy_one(value);
+    } else {
+        return GetOne(value);
+    }
+}
+
+// Additive identity kept symbolic where ring_traits<T>::lazy_zero exists; it becomes a T
+// on conversion, so only callers that need a T pay for building it. Falls back to
+// GetZero.
+template <typename T>
+auto GetLazyZero(const T& value) {
+    if constexpr (requires { ring_traits<T>::lazy_zero(value); }) {
+        return ring_traits<T>::lazy_zero(value);
+    } else {
+        return GetZero(value);
+    }
+}
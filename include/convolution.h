@@ -0,0 +1,368 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "complex_type.h"
+#include "fft.h"
+#include "lazy_reduction.h"
+#include "mp_fwd.h"  // Forward declaration
+#include "ntt.h"
+
+namespace SingleVariable {
+
+// Balanced operands shorter than this are multiplied by the schoolbook method
+inline constexpr size_t kKaratsubaThreshold = 32;
+
+// Balanced operands at least this long use Toom-3 when the coefficients allow it.
+// Its interpolation divides by 2 and 3, see ToomCook3Divisible
+inline constexpr size_t kToomCookThreshold = 256;
+
+// Operands at least this long are multiplied by NTT when the coefficients allow it
+inline constexpr size_t kNttThreshold = 64;
+
+// Operands at least this long are multiplied by FFT when the coefficients allow it
+inline constexpr size_t kFftThreshold = 64;
+
+// Exact and fast algorithms only differ for floating-point coefficients: kExact makes
+// every coefficient of the product the same sum of products schoolbook computes,
+// without the transform error of FFT (see fft.h) or the cancellations of Toom-3.
+enum class ConvolutionMode { kFast, kExact };
+
+// All kernels below accumulate: res[i + j] += lhs[i] * rhs[j]. Coefficients are never
+// reordered inside a product, so non-commutative rings like Matrix<T> are fine.
+
+// Square of commutative coefficients: every cross product a_i a_j with i < j is computed
+// once and added twice, which halves the products
+template <typename T>
+void SchoolbookSquare(const T* values, size_t size, T* res) {
+    for (size_t k = 0; k + 1 < 2 * size; ++k) {
+        size_t begin = k < size ? 0 : k - size + 1;
+        size_t end = (k + 1) / 2;
+        if (begin < end) {
+            if constexpr (lazy_reduction<T>::kEnabled) {
+                T cross = LazyDot(values + begin, values + (k - begin), -1, end - begin);
+                res[k] += cross;
+                res[k] += cross;
+            } else {
+                T cross = values[begin] * values[k - begin];
+                for (size_t i = begin + 1; i < end; ++i) {
+                    cross += values[i] * values[k - i];
+                }
+                res[k] += cross;
+                res[k] += cross;
+            }
+        }
+        if (k % 2 == 0) {
+            res[k] += values[k / 2] * values[k / 2];
+        }
+    }
+}
+
+// Residues with lazy_reduction gather every coefficient as one LazyDot, reduced once per
+// run of products rather than once per product. Squares of exact commutative
+// coefficients go to SchoolbookSquare. Signed integers run as unsigned, see
+// kMultipliedAsUnsigned, so sums that overflow wrap instead of being undefined.
+template <typename T, typename U, typename R>
+void SchoolbookMultiply(const T* lhs, size_t lhs_size, const U* rhs, size_t rhs_size, R* res) {
+    if constexpr (std::is_same_v<T, U> && std::is_same_v<T, R> && kMultipliedAsUnsigned<T>) {
+        using W = std::make_unsigned_t<T>;
+        SchoolbookMultiply(reinterpret_cast<const W*>(lhs), lhs_size,
+                           reinterpret_cast<const W*>(rhs), rhs_size, reinterpret_cast<W*>(res));
+        return;
+    }
+    if constexpr (std::is_same_v<T, U> && std::is_same_v<T, R> && is_exact_ring<T>::value &&
+                  is_commutative<T>::value) {
+        if (lhs == rhs && lhs_size == rhs_size) {
+            SchoolbookSquare(lhs, lhs_size, res);
+            return;
+        }
+    }
+    if constexpr (std::is_same_v<T, U> && std::is_same_v<T, R> && lazy_reduction<T>::kEnabled) {
+        for (size_t k = 0; k + 1 < lhs_size + rhs_size; ++k) {
+            size_t begin = k < rhs_size ? 0 : k - rhs_size + 1;
+            size_t end = std::min(k + 1, lhs_size);
+            res[k] += LazyDot(lhs + begin, rhs + (k - begin), -1, end - begin);
+        }
+        return;
+    }
+    for (size_t i = 0; i < lhs_size; ++i) {
+        for (size_t j = 0; j < rhs_size; ++j) {
+            res[i + j] += lhs[i] * rhs[j];
+        }
+    }
+}
+
+template <typename T, typename U, typename R>
+void MultiplyBalanced(const T* lhs, const U* rhs, size_t size, R* res, const R& zero);
+
+// (a0 + a1 x^h)(b0 + b1 x^h) = z0 + ((a0 + a1)(b0 + b1) - z0 - z2) x^h + z2 x^2h.
+// For a square the three products are squares as well, even without commutativity.
+// Signed integers run as unsigned, since a0 + a1 and the products may overflow: the
+// result is the same modulo 2^N.
+template <typename T, typename U, typename R>
+void KaratsubaMultiply(const T* lhs, const U* rhs, size_t size, R* res, const R& zero) {
+    if constexpr (std::is_same_v<T, U> && std::is_same_v<T, R> && kMultipliedAsUnsigned<T>) {
+        using W = std::make_unsigned_t<T>;
+        KaratsubaMultiply(reinterpret_cast<const W*>(lhs), reinterpret_cast<const W*>(rhs), size,
+                          reinterpret_cast<W*>(res), static_cast<W>(zero));
+        return;
+    }
+    size_t low = size / 2;
+    size_t high = size - low;
+
+    std::vector<T> lhs_sum(lhs + low, lhs + size);
+    for (size_t i = 0; i < low; ++i) {
+        lhs_sum[i] += lhs[i];
+    }
+    std::vector<U> rhs_sum;
+    const U* rhs_sum_data = nullptr;
+    if constexpr (std::is_same_v<T, U>) {
+        if (lhs == rhs) {
+            rhs_sum_data = lhs_sum.data();
+        }
+    }
+    if (rhs_sum_data == nullptr) {
+        rhs_sum.assign(rhs + low, rhs + size);
+        for (size_t i = 0; i < low; ++i) {
+            rhs_sum[i] += rhs[i];
+        }
+        rhs_sum_data = rhs_sum.data();
+    }
+
+    std::vector<R> z0(2 * low - 1, zero);
+    std::vector<R> z1(2 * high - 1, zero);
+    std::vector<R> z2(2 * high - 1, zero);
+    MultiplyBalanced(lhs, rhs, low, z0.data(), zero);
+    MultiplyBalanced(lhs + low, rhs + low, high, z2.data(), zero);
+    MultiplyBalanced(lhs_sum.data(), rhs_sum_data, high, z1.data(), zero);
+
+    for (size_t i = 0; i < z0.size(); ++i) {
+        z1[i] -= z0[i];
+        res[i] += z0[i];
+    }
+    for (size_t i = 0; i < z2.size(); ++i) {
+        z1[i] -= z2[i];
+        res[2 * low + i] += z2[i];
+    }
+    for (size_t i = 0; i < z1.size(); ++i) {
+        res[low + i] += z1[i];
+    }
+}
+
+// Bodrato's interpolation sequence only divides multiples of 2 and 3, so besides
+// coefficients with has_exact_division it is exact for signed integers. Unsigned ones
+// are left out: they wrap around, and halving a wrapped value loses its top bit.
+template <typename T>
+concept ToomCook3Divisible =
+    has_exact_division<T>::value || (std::is_integral_v<T> && std::is_signed_v<T>);
+
+// Integer coefficients only take Toom-3 when no intermediate value wraps around, since
+// dividing a wrapped value by 2 or 3 is wrong: values at -2 grow up to 7 times, their
+// products up to 49 times and the interpolation differences a bit more, so
+// 64 * max|lhs| * max|rhs| * part must fit into T. Recursive calls check their own
+// operands.
+template <typename T>
+bool ToomCook3Fits(const T* lhs, const T* rhs, size_t size) {
+    if constexpr (std::is_integral_v<T>) {
+        using U = std::make_unsigned_t<T>;
+        auto max_magnitude = [size](const T* values) {
+            U res = 0;
+            for (size_t i = 0; i < size; ++i) {
+                U magnitude = values[i] < 0 ? U(0) - U(values[i]) : U(values[i]);
+                res = std::max(res, magnitude);
+            }
+            return res;
+        };
+        U part = (size + 2) / 3;
+        U limit = U(std::numeric_limits<T>::max()) / 64 / part;
+        U lhs_max = max_magnitude(lhs);
+        U rhs_max = lhs == rhs ? lhs_max : max_magnitude(rhs);
+        return lhs_max == 0 || rhs_max <= limit / lhs_max;
+    } else {
+        return true;
+    }
+}
+
+// Exact division by a small constant: integer division for integers, otherwise a
+// multiplication by the inverse, computed once since it can be costly, as for ModInt
+template <typename T>
+class ExactDivisor {
+public:
+    ExactDivisor(int divisor, const T& zero) : divisor_(divisor) {
+        if constexpr (!std::is_integral_v<T>) {
+            inverse_ = GetOne(zero) / T(divisor);
+        }
+    }
+
+    T Divide(const T& value) const {
+        if constexpr (std::is_integral_v<T>) {
+            return value / divisor_;
+        } else {
+            return value * inverse_;
+        }
+    }
+
+private:
+    T divisor_;
+    T inverse_{};
+};
+
+// res += value, wrapping around for the signed integers of kMultipliedAsUnsigned
+template <typename T>
+void AddWrapping(T& res, const T& value) {
+    if constexpr (kMultipliedAsUnsigned<T>) {
+        using W = std::make_unsigned_t<T>;
+        res = static_cast<T>(static_cast<W>(res) + static_cast<W>(value));
+    } else {
+        res += value;
+    }
+}
+
+// Toom-3 with evaluation points 0, 1, -1, -2, inf and Bodrato's interpolation sequence.
+// A square evaluates its operand once. Only the sums into res may wrap around, the
+// caller's earlier terms being unbounded, see ToomCook3Fits.
+template <typename T>
+void ToomCook3Multiply(const T* lhs, const T* rhs, size_t size, T* res, const T& zero) {
+    size_t part = (size + 2) / 3;
+    size_t product = 2 * part - 1;
+
+    // Values at 0, 1, -1, -2 and inf in this order
+    auto evaluate = [&](const T* poly) {
+        std::vector<std::vector<T>> values(5, std::vector<T>(part, zero));
+        for (size_t i = 0; i < part; ++i) {
+            const T& m0 = poly[i];
+            T m1 = part + i < size ? poly[part + i] : zero;
+            T m2 = 2 * part + i < size ? poly[2 * part + i] : zero;
+            T p0 = m0 + m2;
+            values[0][i] = m0;
+            values[1][i] = p0 + m1;
+            values[2][i] = p0 - m1;
+            T tmp = values[2][i] + m2;
+            values[3][i] = tmp + tmp - m0;
+            values[4][i] = m2;
+        }
+        return values;
+    };
+    auto lhs_values = evaluate(lhs);
+    std::vector<std::vector<T>> rhs_values;
+    if (lhs != rhs) {
+        rhs_values = evaluate(rhs);
+    }
+    const auto& rhs_points = lhs == rhs ? lhs_values : rhs_values;
+
+    std::vector<std::vector<T>> r(5, std::vector<T>(product, zero));
+    for (size_t k = 0; k < 5; ++k) {
+        MultiplyBalanced(lhs_values[k].data(), rhs_points[k].data(), part, r[k].data(), zero);
+    }
+
+    const ExactDivisor<T> two(2, zero);
+    const ExactDivisor<T> three(3, zero);
+    size_t res_size = 2 * size - 1;
+    for (size_t i = 0; i < product; ++i) {
+        T r0 = r[0][i];
+        T r4 = r[4][i];
+        T r3 = three.Divide(r[3][i] - r[1][i]);
+        T r1 = two.Divide(r[1][i] - r[2][i]);
+        T r2 = r[2][i] - r0;
+        r3 = two.Divide(r2 - r3) + r4 + r4;
+        r2 = r2 + r1 - r4;
+        r1 = r1 - r3;
+        const T* coefs[5] = {&r0, &r1, &r2, &r3, &r4};
+        for (size_t k = 0; k < 5; ++k) {
+            if (k * part + i < res_size) {
+                AddWrapping(res[k * part + i], *coefs[k]);
+            }
+        }
+    }
+}
+
+template <typename T, typename U, typename R>
+void MultiplyBalanced(const T* lhs, const U* rhs, size_t size, R* res, const R& zero) {
+    if (size < kKaratsubaThreshold) {
+        SchoolbookMultiply(lhs, size, rhs, size, res);
+        return;
+    }
+    if constexpr (std::is_same_v<T, U> && std::is_same_v<T, R> && ToomCook3Divisible<T>) {
+        if (size >= kToomCookThreshold && ToomCook3Fits(lhs, rhs, size)) {
+            ToomCook3Multiply(lhs, rhs, size, res, zero);
+            return;
+        }
+    }
+    KaratsubaMultiply(lhs, rhs, size, res, zero);
+}
+
+// Cuts the longer operand into blocks of the shorter one's length and multiplies
+// the blocks as balanced products
+template <typename T, typename U, typename R>
+void MultiplyUnbalanced(const T* lhs, size_t lhs_size, const U* rhs, size_t rhs_size, R* res,
+                        const R& zero) {
+    if (lhs_size == 0 || rhs_size == 0) {
+        return;
+    }
+    if (lhs_size == rhs_size) {
+        MultiplyBalanced(lhs, rhs, lhs_size, res, zero);
+    } else if (std::min(lhs_size, rhs_size) < kKaratsubaThreshold) {
+        SchoolbookMultiply(lhs, lhs_size, rhs, rhs_size, res);
+    } else if (lhs_size > rhs_size) {
+        size_t start = 0;
+        for (; start + rhs_size <= lhs_size; start += rhs_size) {
+            MultiplyBalanced(lhs + start, rhs, rhs_size, res + start, zero);
+        }
+        MultiplyUnbalanced(lhs + start, lhs_size - start, rhs, rhs_size, res + start, zero);
+    } else {
+        size_t start = 0;
+        for (; start + lhs_size <= rhs_size; start += lhs_size) {
+            MultiplyBalanced(lhs, rhs + start, lhs_size, res + start, zero);
+        }
+        MultiplyUnbalanced(lhs, lhs_size, rhs + start, rhs_size - start, res + start, zero);
+    }
+}
+
+// Zero shaped like the products of the coefficients, such as a zero matrix. Arithmetic
+// types skip the product, which may overflow.
+template <typename T, typename U>
+MultiplyType<T, U> ProductZero(const T& lhs, const U& rhs) {
+    if constexpr (std::is_arithmetic_v<MultiplyType<T, U>>) {
+        return MultiplyType<T, U>(0);
+    } else {
+        return GetZero(lhs * rhs);
+    }
+}
+
+// Coefficients of the product of two dense polynomials given lowest degree first
+template <typename T, typename U>
+std::vector<MultiplyType<T, U>> Convolve(const std::vector<T>& lhs, const std::vector<U>& rhs,
+                                         ConvolutionMode mode = ConvolutionMode::kFast) {
+    using R = MultiplyType<T, U>;
+    if (lhs.empty() || rhs.empty()) {
+        return {};
+    }
+    if constexpr (std::is_floating_point_v<R> || fft_traits<R>::kEnabled) {
+        if (mode == ConvolutionMode::kExact) {
+            std::vector<R> res(lhs.size() + rhs.size() - 1, ProductZero(lhs.front(), rhs.front()));
+            SchoolbookMultiply(lhs.data(), lhs.size(), rhs.data(), rhs.size(), res.data());
+            return res;
+        }
+    }
+    if constexpr (std::is_same_v<T, U> && fft_traits<T>::kEnabled) {
+        if (std::min(lhs.size(), rhs.size()) >= kFftThreshold) {
+            return FftConvolve(lhs, rhs);
+        }
+    }
+    if constexpr (std::is_same_v<T, U> && ntt_traits<T>::kEnabled) {
+        if (std::min(lhs.size(), rhs.size()) >= kNttThreshold &&
+            lhs.size() + rhs.size() - 1 <= ntt_traits<T>::kMaxSize) {
+            return NttConvolve(lhs, rhs);
+        }
+    }
+    R zero = ProductZero(lhs.front(), rhs.front());
+    std::vector<R> res(lhs.size() + rhs.size() - 1, zero);
+    MultiplyUnbalanced(lhs.data(), lhs.size(), rhs.data(), rhs.size(), res.data(), zero);
+    return res;
+}
+
+}  // namespace SingleVariable
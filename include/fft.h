@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mp_fwd.h"  // Forward declaration
+
+template <typename T>
+struct has_exact_division<std::complex<T>> : std::is_floating_point<T> {};
+
+template <typename T>
+struct is_commutative<std::complex<T>> : std::is_arithmetic<T> {};
+
+namespace SingleVariable {
+
+template <typename T>
+struct fft_traits {
+    static constexpr bool kEnabled = false;
+};
+
+template <>
+struct fft_traits<double> {
+    static constexpr bool kEnabled = true;
+};
+
+template <>
+struct fft_traits<std::complex<double>> {
+    static constexpr bool kEnabled = true;
+};
+
+// roots[len + j] = exp(i * pi * j / len). Odd entries are computed directly instead of
+// by repeated multiplication so every twiddle is correctly rounded.
+inline const std::vector<std::complex<double>>& FftRoots(size_t size) {
+    thread_local std::vector<std::complex<double>> roots{{0, 0}, {1, 0}};
+    for (size_t len = roots.size(); len < size; len *= 2) {
+        roots.resize(2 * len);
+        for (size_t j = 0; j < len; j += 2) {
+            roots[len + j] = roots[len / 2 + j / 2];
+            roots[len + j + 1] =
+                std::polar(1.0, std::numbers::pi * static_cast<double>(j + 1) / len);
+        }
+    }
+    return roots;
+}
+
+// In-place iterative transform, size must be a power of two
+inline void Fft(std::vector<std::complex<double>>& values) {
+    size_t size = values.size();
+    for (size_t i = 1, j = 0; i < size; ++i) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(values[i], values[j]);
+        }
+    }
+    const auto& roots = FftRoots(size);
+    for (size_t len = 1; len < size; len *= 2) {
+        for (size_t start = 0; start < size; start += 2 * len) {
+            for (size_t j = 0; j < len; ++j) {
+                std::complex<double> u = values[start + j];
+                std::complex<double> v = values[start + j + len] * roots[len + j];
+                values[start + j] = u + v;
+                values[start + j + len] = u - v;
+            }
+        }
+    }
+}
+
+inline void InverseFft(std::vector<std::complex<double>>& values) {
+    Fft(values);
+    std::reverse(values.begin() + 1, values.end());
+    double inv_size = 1.0 / static_cast<double>(values.size());
+    for (auto& value : values) {
+        value *= inv_size;
+    }
+}
+
+// Error bound for both overloads: with eps = 2^-53 and N the transform length, every
+// coefficient differs from the exact convolution by at most about
+//     3 * eps * log2(N) * |lhs|_2 * |rhs|_2,
+// where |.|_2 is the euclidean norm of the coefficient vector. The error is absolute,
+// so small coefficients next to large ones lose relative precision. Pass
+// ConvolutionMode::kExact to Convolve or Polynomial::Multiply to avoid it.
+
+// Real inputs are packed into one complex vector lhs + i * rhs, so the product needs a
+// single forward and a single inverse transform
+inline std::vector<double> FftConvolve(const std::vector<double>& lhs,
+                                       const std::vector<double>& rhs) {
+    size_t res_size = lhs.size() + rhs.size() - 1;
+    size_t size = std::bit_ceil(res_size);
+    std::vector<std::complex<double>> values(size);
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        values[i].real(lhs[i]);
+    }
+    for (size_t i = 0; i < rhs.size(); ++i) {
+        values[i].imag(rhs[i]);
+    }
+    Fft(values);
+    // L[k] * R[k] = (C[k]^2 - conj(C[-k])^2) / 4i, computed for k and -k at once
+    const std::complex<double> quarter_i(0, 0.25);
+    for (size_t k = 0; k <= size / 2; ++k) {
+        size_t neg = (size - k) & (size - 1);
+        std::complex<double> direct = values[k] * values[k];
+        std::complex<double> mirror = values[neg] * values[neg];
+        values[k] = (std::conj(mirror) - direct) * quarter_i;
+        values[neg] = (std::conj(direct) - mirror) * quarter_i;
+    }
+    InverseFft(values);
+    std::vector<double> res(res_size);
+    for (size_t i = 0; i < res_size; ++i) {
+        res[i] = values[i].real();
+    }
+    return res;
+}
+
+// A square, lhs and rhs being the same vector, takes one forward transform
+inline std::vector<std::complex<double>> FftConvolve(const std::vector<std::complex<double>>& lhs,
+                                                     const std::vector<std::complex<double>>& rhs) {
+    size_t res_size = lhs.size() + rhs.size() - 1;
+    size_t size = std::bit_ceil(res_size);
+    std::vector<std::complex<double>> lhs_values(lhs);
+    lhs_values.resize(size);
+    Fft(lhs_values);
+    if (&lhs == &rhs) {
+        for (auto& value : lhs_values) {
+            value *= value;
+        }
+    } else {
+        std::vector<std::complex<double>> rhs_values(rhs);
+        rhs_values.resize(size);
+        Fft(rhs_values);
+        for (size_t i = 0; i < size; ++i) {
+            lhs_values[i] *= rhs_values[i];
+        }
+    }
+    InverseFft(lhs_values);
+    lhs_values.resize(res_size);
+    return lhs_values;
+}
+
+}  // namespace SingleVariable
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Calls f(std::integral_constant<size_t, I>) for I in [0, N) without a loop
+template <size_t N, typename F>
+constexpr void Unroll(F&& f) {
+    [&f]<size_t... I>(std::index_sequence<I...>) {
+        (f(std::integral_constant<size_t, I>{}), ...);
+    }(std::make_index_sequence<N>{});
+}
+
+// Matrix with compile-time shape, stored inline. All operations are constexpr and
+// unrolled. The shape needs no DefaultParams, so GetConst builds it from the value alone
+// and it works as a Polynomial coefficient or evaluation point without heap use.
+template <typename T, size_t R, size_t C = R>
+class FixedMatrix {
+public:
+    constexpr FixedMatrix() : data_{} {
+    }
+
+    // Same rule as Matrix(DefaultParams, value): identity for a square shape and
+    // value == 1, otherwise every element equals value
+    constexpr explicit FixedMatrix(const T& value) : data_{} {
+        if (R == C && value == T(1)) {
+            Unroll<R>([this](auto i) { (*this)(i, i) = T(1); });
+        } else {
+            data_.fill(value);
+        }
+    }
+
+    constexpr FixedMatrix(std::initializer_list<std::initializer_list<T>> rows) : data_{} {
+        if (rows.size() != R) {
+            throw std::runtime_error{"Wrong number of rows for a fixed matrix"};
+        }
+        size_t i = 0;
+        for (const auto& row : rows) {
+            if (row.size() != C) {
+                throw std::runtime_error{"Wrong number of columns for a fixed matrix"};
+            }
+            size_t j = 0;
+            for (const auto& value : row) {
+                data_[i * C + j++] = value;
+            }
+            ++i;
+        }
+    }
+
+    static constexpr size_t Rows() {
+        return R;
+    }
+
+    static constexpr size_t Columns() {
+        return C;
+    }
+
+    static constexpr std::pair<size_t, size_t> Shape() {
+        return {R, C};
+    }
+
+    constexpr T& operator()(size_t i, size_t j) {
+        return data_[i * C + j];
+    }
+
+    constexpr const T& operator()(size_t i, size_t j) const {
+        return data_[i * C + j];
+    }
+
+    constexpr FixedMatrix& operator+=(const FixedMatrix& rhs) {
+        Unroll<R * C>([&](auto k) { data_[k] += rhs.data_[k]; });
+        return *this;
+    }
+
+    constexpr FixedMatrix& operator-=(const FixedMatrix& rhs) {
+        Unroll<R * C>([&](auto k) { data_[k] -= rhs.data_[k]; });
+        return *this;
+    }
+
+    constexpr FixedMatrix& operator*=(const T& multiplyer) {
+        Unroll<R * C>([&](auto k) { data_[k] *= multiplyer; });
+        return *this;
+    }
+
+    constexpr FixedMatrix& operator*=(const FixedMatrix& rhs)
+        requires(R == C)
+    {
+        *this = *this * rhs;
+        return *this;
+    }
+
+    constexpr FixedMatrix operator-() const {
+        FixedMatrix res;
+        Unroll<R * C>([&](auto k) { res.data_[k] = -data_[k]; });
+        return res;
+    }
+
+    friend constexpr FixedMatrix operator+(FixedMatrix lhs, const FixedMatrix& rhs) {
+        return lhs += rhs;
+    }
+
+    friend constexpr FixedMatrix operator-(FixedMatrix lhs, const FixedMatrix& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend constexpr FixedMatrix operator*(FixedMatrix lhs, const T& multiplyer) {
+        return lhs *= multiplyer;
+    }
+
+    friend constexpr bool operator==(const FixedMatrix& lhs, const FixedMatrix& rhs) {
+        return lhs.data_ == rhs.data_;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const FixedMatrix& matrix) {
+        for (size_t row = 0; row < R; ++row) {
+            for (size_t col = 0; col < C; ++col) {
+                os << matrix(row, col) << ' ';
+            }
+            os << '\n';
+        }
+        return os;
+    }
+
+private:
+    std::array<T, R * C> data_;
+};
+
+template <typename T>
+struct is_fixed_matrix : std::false_type {};
+
+template <typename T, size_t R, size_t C>
+struct is_fixed_matrix<FixedMatrix<T, R, C>> : std::true_type {};
+
+template <typename T, size_t R, size_t K, size_t C>
+constexpr FixedMatrix<T, R, C> operator*(const FixedMatrix<T, R, K>& lhs,
+                                         const FixedMatrix<T, K, C>& rhs) {
+    FixedMatrix<T, R, C> res;
+    Unroll<R * C>([&](auto index) {
+        constexpr size_t kRow = index / C;
+        constexpr size_t kCol = index % C;
+        Unroll<K>([&](auto k) { res(kRow, kCol) += lhs(kRow, k) * rhs(k, kCol); });
+    });
+    return res;
+}
+
+template <typename U, typename T, size_t R, size_t C>
+    requires(!is_fixed_matrix<U>::value)
+constexpr FixedMatrix<T, R, C> operator*(const U& multiplyer, const FixedMatrix<T, R, C>& rhs) {
+    FixedMatrix<T, R, C> res;
+    Unroll<R * C>([&](auto k) { res(k / C, k % C) = multiplyer * rhs(k / C, k % C); });
+    return res;
+}
+
+template <typename T, size_t R, size_t C>
+constexpr FixedMatrix<T, C, R> Transpose(const FixedMatrix<T, R, C>& matrix) {
+    FixedMatrix<T, C, R> transposed;
+    Unroll<R * C>([&](auto k) { transposed(k % C, k / C) = matrix(k / C, k % C); });
+    return transposed;
+}
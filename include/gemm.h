@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "aligned_allocator.h"
+#include "lazy_reduction.h"
+#include "matrix_view.h"
+#include "mp_fwd.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+// Products with fewer multiply-adds than this skip packing and run a plain loop
+inline constexpr size_t kGemmBlockedThreshold = 32 * 32 * 32;
+
+// Products with fewer multiply-adds than this never leave the calling thread
+inline constexpr size_t kGemmParallelThreshold = 128 * 128 * 128;
+
+// Tiles of C handed out to the thread pool
+inline constexpr size_t kGemmParallelRows = 128;
+inline constexpr size_t kGemmParallelColumns = 512;
+
+// Block sizes in elements, picked for 8-byte elements: a KC x NR panel of B stays in L1,
+// an MC x KC block of A in L2 and a KC x NC block of B in L3
+inline constexpr size_t kGemmKc = 256;
+inline constexpr size_t kGemmMc = 128;
+inline constexpr size_t kGemmNc = 2048;
+
+// Portable microkernel: an MR x NR block of C from an MR-row panel of A and an NR-column
+// panel of B, both packed k-major. The fixed trip counts let the compiler vectorize it
+// with the baseline instruction set, SSE2 on x86-64.
+template <typename T, size_t Mr, size_t Nr>
+void GemmKernelGeneric(size_t depth, const T* a, const T* b, T* c, size_t ldc, size_t rows,
+                       size_t cols) {
+    T acc[Mr][Nr] = {};
+    for (size_t p = 0; p < depth; ++p) {
+        for (size_t r = 0; r < Mr; ++r) {
+            for (size_t s = 0; s < Nr; ++s) {
+                acc[r][s] += a[r] * b[s];
+            }
+        }
+        a += Mr;
+        b += Nr;
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t s = 0; s < cols; ++s) {
+            c[r * ldc + s] += acc[r][s];
+        }
+    }
+}
+
+// Microkernel for residues with lazy_reduction: products are summed unreduced in 64 bits
+// and folded once every Terms() steps of the depth instead of after every product
+template <typename T, size_t Mr, size_t Nr>
+void GemmKernelLazy(size_t depth, const T* a, const T* b, T* c, size_t ldc, size_t rows,
+                    size_t cols) {
+    using Traits = lazy_reduction<T>;
+    size_t terms = Traits::Terms();
+    uint64_t acc[Mr][Nr] = {};
+    for (size_t start = 0; start < depth; start += terms) {
+        size_t end = start + std::min(terms, depth - start);
+        for (size_t p = start; p < end; ++p) {
+            for (size_t r = 0; r < Mr; ++r) {
+                uint64_t lhs = Traits::Raw(a[r]);
+                for (size_t s = 0; s < Nr; ++s) {
+                    acc[r][s] += lhs * Traits::Raw(b[s]);
+                }
+            }
+            a += Mr;
+            b += Nr;
+        }
+        for (size_t r = 0; r < Mr; ++r) {
+            for (size_t s = 0; s < Nr; ++s) {
+                acc[r][s] = Traits::Fold(acc[r][s]);
+            }
+        }
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t s = 0; s < cols; ++s) {
+            c[r * ldc + s] += Traits::FromSum(acc[r][s]);
+        }
+    }
+}
+
+#ifdef POLYNOMIAL_X86_DISPATCH
+
+// Kernel body shared by the instruction sets. It is forced inline into the wrappers
+// below, so it is compiled with their target attributes and Vec's operations inline.
+// GCC still warns that its vector values would change the ABI of a standalone copy,
+// which never exists. Every row of the tile keeps Nr / kWidth accumulator registers.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+template <typename Vec, size_t Mr, size_t Nr, typename W>
+[[gnu::always_inline]] inline void GemmKernelVector(size_t depth, const W* a, const W* b, W* c,
+                                                    size_t ldc, size_t rows, size_t cols) {
+    constexpr size_t kVecs = Nr / Vec::kWidth;
+    typename Vec::Type acc[Mr][kVecs];
+    for (size_t r = 0; r < Mr; ++r) {
+        for (size_t v = 0; v < kVecs; ++v) {
+            acc[r][v] = Vec::Broadcast(W(0));
+        }
+    }
+    for (size_t p = 0; p < depth; ++p) {
+        typename Vec::Type row[kVecs];
+        for (size_t v = 0; v < kVecs; ++v) {
+            row[v] = Vec::Load(b + v * Vec::kWidth);
+        }
+        for (size_t r = 0; r < Mr; ++r) {
+            auto value = Vec::Broadcast(a[r]);
+            for (size_t v = 0; v < kVecs; ++v) {
+                acc[r][v] = Vec::MulAdd(value, row[v], acc[r][v]);
+            }
+        }
+        a += Mr;
+        b += Nr;
+    }
+    if (rows == Mr && cols == Nr) {
+        for (size_t r = 0; r < Mr; ++r) {
+            for (size_t v = 0; v < kVecs; ++v) {
+                W* ptr = c + r * ldc + v * Vec::kWidth;
+                Vec::Store(ptr, Vec::Add(Vec::Load(ptr), acc[r][v]));
+            }
+        }
+        return;
+    }
+    W tile[Mr * Nr];
+    for (size_t r = 0; r < Mr; ++r) {
+        for (size_t v = 0; v < kVecs; ++v) {
+            Vec::Store(tile + r * Nr + v * Vec::kWidth, acc[r][v]);
+        }
+    }
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t s = 0; s < cols; ++s) {
+            c[r * ldc + s] += tile[r * Nr + s];
+        }
+    }
+}
+#pragma GCC diagnostic pop
+
+template <typename Vec, size_t Mr, size_t Nr, typename W>
+POLYNOMIAL_AVX2 void GemmKernelAvx2(size_t depth, const W* a, const W* b, W* c, size_t ldc,
+                                    size_t rows, size_t cols) {
+    GemmKernelVector<Vec, Mr, Nr>(depth, a, b, c, ldc, rows, cols);
+}
+
+template <typename Vec, size_t Mr, size_t Nr, typename W>
+POLYNOMIAL_AVX512 void GemmKernelAvx512(size_t depth, const W* a, const W* b, W* c, size_t ldc,
+                                        size_t rows, size_t cols) {
+    GemmKernelVector<Vec, Mr, Nr>(depth, a, b, c, ldc, rows, cols);
+}
+
+template <typename W>
+struct x86_vectors;
+
+template <>
+struct x86_vectors<double> {
+    using Avx2 = Avx2Double;
+    using Avx512 = Avx512Double;
+};
+
+template <>
+struct x86_vectors<float> {
+    using Avx2 = Avx2Float;
+    using Avx512 = Avx512Float;
+};
+
+template <>
+struct x86_vectors<uint32_t> {
+    using Avx2 = Avx2Uint32;
+    using Avx512 = Avx512Uint32;
+};
+
+#endif
+
+// Widest kernel the processor supports. The tile is the same for all of them because
+// the panels are packed before the kernel runs.
+template <typename W, size_t Mr, size_t Nr>
+void GemmKernelSimd(size_t depth, const W* a, const W* b, W* c, size_t ldc, size_t rows,
+                    size_t cols) {
+#ifdef POLYNOMIAL_X86_DISPATCH
+    if (HasAvx512()) {
+        GemmKernelAvx512<typename x86_vectors<W>::Avx512, Mr, Nr>(depth, a, b, c, ldc, rows,
+                                                                  cols);
+        return;
+    }
+    if (HasAvx2Fma()) {
+        GemmKernelAvx2<typename x86_vectors<W>::Avx2, Mr, Nr>(depth, a, b, c, ldc, rows, cols);
+        return;
+    }
+#endif
+    GemmKernelGeneric<W, Mr, Nr>(depth, a, b, c, ldc, rows, cols);
+}
+
+// Microkernel and register tile used by Gemm for element type T
+template <typename T>
+struct gemm_kernel {
+    static constexpr size_t kMr = 4;
+    static constexpr size_t kNr = 4;
+
+    static void Run(size_t depth, const T* a, const T* b, T* c, size_t ldc, size_t rows,
+                    size_t cols) {
+        if constexpr (lazy_reduction<T>::kEnabled) {
+            GemmKernelLazy<T, kMr, kNr>(depth, a, b, c, ldc, rows, cols);
+        } else {
+            GemmKernelGeneric<T, kMr, kNr>(depth, a, b, c, ldc, rows, cols);
+        }
+    }
+};
+
+// 6 x 2 accumulator registers with AVX2, leaving room for the row of B and a broadcast
+template <>
+struct gemm_kernel<double> {
+    static constexpr size_t kMr = 6;
+    static constexpr size_t kNr = 8;
+
+    static void Run(size_t depth, const double* a, const double* b, double* c, size_t ldc,
+                    size_t rows, size_t cols) {
+        GemmKernelSimd<double, kMr, kNr>(depth, a, b, c, ldc, rows, cols);
+    }
+};
+
+template <>
+struct gemm_kernel<float> {
+    static constexpr size_t kMr = 6;
+    static constexpr size_t kNr = 16;
+
+    static void Run(size_t depth, const float* a, const float* b, float* c, size_t ldc,
+                    size_t rows, size_t cols) {
+        GemmKernelSimd<float, kMr, kNr>(depth, a, b, c, ldc, rows, cols);
+    }
+};
+
+template <>
+struct gemm_kernel<uint32_t> {
+    static constexpr size_t kMr = 6;
+    static constexpr size_t kNr = 16;
+
+    static void Run(size_t depth, const uint32_t* a, const uint32_t* b, uint32_t* c, size_t ldc,
+                    size_t rows, size_t cols) {
+        GemmKernelSimd<uint32_t, kMr, kNr>(depth, a, b, c, ldc, rows, cols);
+    }
+};
+
+// Packing copies elements into scratch buffers, which only pays off for plain data
+template <typename T>
+inline constexpr bool kGemmBlocked = std::is_trivially_copyable_v<T>;
+
+// The same view over the unsigned type of the same width
+template <typename T>
+ConstMatrixView<std::make_unsigned_t<T>> UnsignedView(ConstMatrixView<T> view) {
+    return {reinterpret_cast<const std::make_unsigned_t<T>*>(view.Data()), view.Rows(),
+            view.Columns(), view.RowStride(), view.ColumnStride()};
+}
+
+// C += A * B for an m x k view A and a k x n view B, row i of C starting at c + i * ldc
+template <typename T>
+void GemmNaive(ConstMatrixView<T> a, ConstMatrixView<T> b, T* c, size_t ldc) {
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        T* c_row = c + i * ldc;
+        for (size_t p = 0; p < a.Columns(); ++p) {
+            const T& value = a(i, p);
+            for (size_t j = 0; j < b.Columns(); ++j) {
+                c_row[j] += value * b(p, j);
+            }
+        }
+    }
+}
+
+// A block into MR-row panels, short panels padded with zeros
+template <typename T, size_t Mr>
+void PackA(ConstMatrixView<T> a, T* packed) {
+    for (size_t i = 0; i < a.Rows(); i += Mr) {
+        size_t height = std::min(Mr, a.Rows() - i);
+        for (size_t p = 0; p < a.Columns(); ++p) {
+            for (size_t r = 0; r < height; ++r) {
+                packed[r] = a(i + r, p);
+            }
+            std::fill(packed + height, packed + Mr, T{});
+            packed += Mr;
+        }
+    }
+}
+
+// B block into NR-column panels, short panels padded with zeros
+template <typename T, size_t Nr>
+void PackB(ConstMatrixView<T> b, T* packed) {
+    for (size_t j = 0; j < b.Columns(); j += Nr) {
+        size_t width = std::min(Nr, b.Columns() - j);
+        for (size_t p = 0; p < b.Rows(); ++p) {
+            for (size_t s = 0; s < width; ++s) {
+                packed[s] = b(p, j + s);
+            }
+            std::fill(packed + width, packed + Nr, T{});
+            packed += Nr;
+        }
+    }
+}
+
+// C += A * B by the Goto scheme: B is packed once per KC x NC block, A once per MC x KC
+// block, and the microkernel sweeps register tiles of C over the packed panels. Packing
+// reads A and B through their strides, so transposed views cost nothing extra.
+// Signed integers of rank int and above are multiplied as unsigned by both paths, see
+// kMultipliedAsUnsigned: overflow is defined, and int32_t gets the uint32_t kernels.
+template <typename T>
+void Gemm(ConstMatrixView<T> a, ConstMatrixView<T> b, T* c, size_t ldc) {
+    size_t m = a.Rows();
+    size_t n = b.Columns();
+    size_t k = a.Columns();
+    if constexpr (kMultipliedAsUnsigned<T>) {
+        Gemm(UnsignedView(a), UnsignedView(b), reinterpret_cast<std::make_unsigned_t<T>*>(c), ldc);
+    } else if constexpr (!kGemmBlocked<T>) {
+        GemmNaive(a, b, c, ldc);
+    } else {
+        if (m * n * k < kGemmBlockedThreshold) {
+            GemmNaive(a, b, c, ldc);
+            return;
+        }
+        using Kernel = gemm_kernel<T>;
+        constexpr size_t kMr = Kernel::kMr;
+        constexpr size_t kNr = Kernel::kNr;
+        size_t mc = (std::min(kGemmMc, m) + kMr - 1) / kMr * kMr;
+        size_t nc = (std::min(kGemmNc, n) + kNr - 1) / kNr * kNr;
+        size_t kc = std::min(kGemmKc, k);
+        std::vector<T, AlignedAllocator<T>> packed_a(mc * kc);
+        std::vector<T, AlignedAllocator<T>> packed_b(kc * nc);
+
+        for (size_t jc = 0; jc < n; jc += kGemmNc) {
+            size_t cols = std::min(kGemmNc, n - jc);
+            for (size_t pc = 0; pc < k; pc += kGemmKc) {
+                size_t depth = std::min(kGemmKc, k - pc);
+                PackB<T, kNr>(b.Block(pc, jc, depth, cols), packed_b.data());
+                for (size_t ic = 0; ic < m; ic += kGemmMc) {
+                    size_t rows = std::min(kGemmMc, m - ic);
+                    PackA<T, kMr>(a.Block(ic, pc, rows, depth), packed_a.data());
+                    for (size_t jr = 0; jr < cols; jr += kNr) {
+                        for (size_t ir = 0; ir < rows; ir += kMr) {
+                            Kernel::Run(depth, packed_a.data() + ir * depth,
+                                        packed_b.data() + jr * depth,
+                                        c + (ic + ir) * ldc + jc + jr, ldc,
+                                        std::min(kMr, rows - ir), std::min(kNr, cols - jr));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Gemm with the tiles of C spread over the global thread pool. threads == 0 takes every
+// thread of the pool; each tile packs its own panels, so tiles share nothing but A and B.
+template <typename T>
+void GemmParallel(ConstMatrixView<T> a, ConstMatrixView<T> b, T* c, size_t ldc,
+                  size_t threads = 0) {
+    size_t m = a.Rows();
+    size_t n = b.Columns();
+    size_t k = a.Columns();
+    if (threads == 1 || m * n * k < kGemmParallelThreshold) {
+        Gemm(a, b, c, ldc);
+        return;
+    }
+    size_t row_tiles = (m + kGemmParallelRows - 1) / kGemmParallelRows;
+    size_t col_tiles = (n + kGemmParallelColumns - 1) / kGemmParallelColumns;
+    ThreadPool::Global().ParallelFor(
+        row_tiles * col_tiles,
+        [&](size_t tile) {
+            size_t row = tile / col_tiles * kGemmParallelRows;
+            size_t col = tile % col_tiles * kGemmParallelColumns;
+            size_t rows = std::min(kGemmParallelRows, m - row);
+            size_t cols = std::min(kGemmParallelColumns, n - col);
+            Gemm(a.Block(row, 0, rows, k), b.Block(0, col, k, cols), c + row * ldc + col, ldc);
+        },
+        threads);
+}
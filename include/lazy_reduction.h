@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Residue types whose products may be summed unreduced, with a single reduction per
+// run of products instead of one per product. A specialization provides
+//   Raw(x)     - the stored residue of x, below Modulus()
+//   Modulus()  - the modulus
+//   Terms()    - how many products of two residues fit into uint64_t next to a residue
+//   Fold(s)    - s reduced below Modulus(), keeping its class
+//   FromSum(s) - the value a sum s of products of residues stands for
+// See modint.h. Used by Gemm and SchoolbookMultiply.
+template <typename T>
+struct lazy_reduction {
+    static constexpr bool kEnabled = false;
+};
+
+// Largest number of products of two residues below modulus that can be added to one
+// residue without overflowing uint64_t
+constexpr size_t LazyTerms(uint32_t modulus) {
+    uint64_t max_residue = modulus - 1;
+    if (max_residue <= 1) {
+        return SIZE_MAX;
+    }
+    return static_cast<size_t>((UINT64_MAX - max_residue) / (max_residue * max_residue));
+}
+
+// sum of lhs[i] * rhs[i * rhs_step] for i < size
+template <typename T>
+T LazyDot(const T* lhs, const T* rhs, ptrdiff_t rhs_step, size_t size) {
+    using Traits = lazy_reduction<T>;
+    size_t terms = Traits::Terms();
+    uint64_t sum = 0;
+    for (size_t start = 0; start < size; start += terms) {
+        size_t end = start + std::min(terms, size - start);
+        for (size_t i = start; i < end; ++i) {
+            sum += static_cast<uint64_t>(Traits::Raw(lhs[i])) *
+                   Traits::Raw(rhs[static_cast<ptrdiff_t>(i) * rhs_step]);
+        }
+        sum = Traits::Fold(sum);
+    }
+    return Traits::FromSum(sum);
+}
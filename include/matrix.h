@@ -1,13 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <any>
 #include <cstddef>
 #include <initializer_list>
 #include <ostream>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "aligned_allocator.h"
 #include "complex_type.h"
+#include "gemm.h"
+#include "matrix_expression.h"
+#include "matrix_view.h"
+#include "scaled_identity.h"
+#include "strassen.h"
+#include "transpose.h"
 
 template <typename T>
 class Matrix;
@@ -15,108 +25,347 @@ class Matrix;
 template <typename T>
 Matrix<T> Identity(size_t n);
 
+// Largest buffer Matrix::operator*= keeps per thread for the next product
+inline constexpr size_t kProductScratchBytes = size_t{4} << 20;
+
+// Elements live in one buffer aligned to a cache line, row i starting at i * Stride().
+// For arithmetic types rows are padded to a whole number of cache lines, so every row
+// is aligned as well, unless TransposeInPlace had to drop the padding. Padding is
+// value-initialized and never read by the operations.
 template <class T>
-class Matrix : public ComplexType {
+class Matrix {
+    static_assert(!std::is_same_v<T, bool>,
+                  "Matrix<bool> is not supported: std::vector<bool> packs bits, so rows have no "
+                  "T* pointers; use Matrix<uint8_t> instead");
+
 public:
-    Matrix(size_t rows, size_t cols) : data_(rows, std::vector<T>(cols)) {
+    Matrix(size_t rows, size_t cols)
+        : rows_(rows), cols_(rows == 0 ? 0 : cols), stride_(RowStride(cols_)),
+          data_(rows_ * stride_) {
+    }
+
+    Matrix(size_t dim) : Matrix(dim, dim) {
+    }
+
+    Matrix(const std::vector<std::vector<T>>& data)
+        : Matrix(data.size(), data.empty() ? 0 : data.front().size()) {
+        CopyRows(data);
+    }
+
+    Matrix(const std::initializer_list<std::vector<T>>& data)
+        : Matrix(data.size(), data.size() == 0 ? 0 : data.begin()->size()) {
+        CopyRows(data);
     }
 
-    Matrix(size_t dim) : data_(dim, std::vector<T>(dim)) {
+    explicit Matrix(ConstMatrixView<T> view) : Matrix(view.Rows(), view.Columns()) {
+        View().Assign(view);
     }
 
-    Matrix(const std::vector<std::vector<T>>& data) : data_(data) {
+    // Evaluates a lazy expression, see matrix_expression.h
+    template <MatrixExpression E>
+        requires std::is_same_v<OperandElement<E>, T>
+    Matrix(const E& expr) : Matrix(expr.Rows(), expr.Columns()) {
+        EvaluateExpression(expr, Row(0), stride_, false);
     }
 
-    Matrix(const std::initializer_list<std::vector<T>>& data) : data_(data) {
+    // scalar on the main diagonal, zeros elsewhere
+    Matrix(const ScaledIdentity<T>& identity) : Matrix(identity.Rows(), identity.Columns()) {
+        for (size_t i = 0; i < identity.Diagonal(); ++i) {
+            (*this)(i, i) = identity.Scalar();
+        }
     }
 
+    // Same as Constant, for code still passing shapes through GetDefaultParams
     Matrix(const struct DefaultParams& params, const T& value) {
-        T one = GetOne(value);
         auto shape = std::any_cast<std::pair<size_t, size_t>>(params.data);
-        if (shape.first != shape.second || value != one) {
-            data_.resize(shape.first, std::vector<T>(shape.second, value));
-        } else {
-            *this = std::move(Identity<T>(shape.first));
+        *this = Constant(shape.first, shape.second, value);
+    }
+
+    // Identity for a square shape and value == 1, otherwise every element equals value
+    static Matrix Constant(size_t rows, size_t cols, const T& value) {
+        if (rows == cols && value == GetOne(value)) {
+            return Identity<T>(rows);
         }
+        Matrix res(rows, cols);
+        for (size_t i = 0; i < res.rows_; ++i) {
+            std::fill_n(res.Row(i), res.cols_, value);
+        }
+        return res;
+    }
+
+    ConstMatrixView<T> View() const {
+        return {data_.data(), rows_, cols_, stride_};
+    }
+
+    MatrixView<T> View() {
+        return {data_.data(), rows_, cols_, stride_};
+    }
+
+    operator ConstMatrixView<T>() const {
+        return View();
+    }
+
+    operator MatrixView<T>() {
+        return View();
+    }
+
+    ConstMatrixView<T> Block(size_t row, size_t col, size_t rows, size_t cols) const {
+        return View().Block(row, col, rows, cols);
+    }
+
+    MatrixView<T> Block(size_t row, size_t col, size_t rows, size_t cols) {
+        return View().Block(row, col, rows, cols);
     }
 
     std::pair<size_t, size_t> Shape() const {
-        if (data_.empty()) {
-            return {0, 0};
-        }
-        return {data_.size(), data_[0].size()};
+        return {rows_, cols_};
     }
 
     size_t Rows() const {
-        return data_.size();
+        return rows_;
     }
 
     size_t Columns() const {
-        if (data_.empty()) {
-            return 0;
-        }
-        return data_[0].size();
+        return cols_;
+    }
+
+    // Distance in elements between the starts of consecutive rows
+    size_t Stride() const {
+        return stride_;
+    }
+
+    T* Row(size_t i) {
+        return data_.data() + i * stride_;
+    }
+
+    const T* Row(size_t i) const {
+        return data_.data() + i * stride_;
     }
 
     T& operator()(size_t i, size_t j) {
-        return data_[i][j];
+        return data_[i * stride_ + j];
     }
 
     const T& operator()(size_t i, size_t j) const {
-        return data_[i][j];
+        return data_[i * stride_ + j];
     }
 
     Matrix& operator+=(const Matrix& rhs) {
-        for (size_t i = 0; i < Rows(); ++i) {
-            for (size_t j = 0; j < Columns(); ++j) {
-                data_[i][j] += rhs.data_[i][j];
+        for (size_t i = 0; i < rows_; ++i) {
+            T* row = Row(i);
+            const T* rhs_row = rhs.Row(i);
+            for (size_t j = 0; j < cols_; ++j) {
+                row[j] += rhs_row[j];
             }
         }
         return *this;
     }
 
     Matrix& operator-=(const Matrix& rhs) {
-        for (size_t i = 0; i < Rows(); ++i) {
-            for (size_t j = 0; j < Columns(); ++j) {
-                data_[i][j] -= rhs.data_[i][j];
+        for (size_t i = 0; i < rows_; ++i) {
+            T* row = Row(i);
+            const T* rhs_row = rhs.Row(i);
+            for (size_t j = 0; j < cols_; ++j) {
+                row[j] -= rhs_row[j];
             }
         }
         return *this;
     }
 
+    // Only the diagonal changes
+    Matrix& operator+=(const ScaledIdentity<T>& identity) {
+        CheckSameShape(*this, identity);
+        for (size_t i = 0; i < identity.Diagonal(); ++i) {
+            (*this)(i, i) += identity.Scalar();
+        }
+        return *this;
+    }
+
+    Matrix& operator-=(const ScaledIdentity<T>& identity) {
+        CheckSameShape(*this, identity);
+        for (size_t i = 0; i < identity.Diagonal(); ++i) {
+            (*this)(i, i) -= identity.Scalar();
+        }
+        return *this;
+    }
+
     Matrix& operator*=(const T& multiplyer) {
-        for (size_t i = 0; i < Rows(); ++i) {
-            for (size_t j = 0; j < Columns(); ++j) {
-                data_[i][j] *= multiplyer;
+        for (size_t i = 0; i < rows_; ++i) {
+            T* row = Row(i);
+            for (size_t j = 0; j < cols_; ++j) {
+                row[j] *= multiplyer;
             }
         }
         return *this;
     }
 
+    // Expressions are evaluated straight into the matrix unless an operand overlaps it
+    // other than element by element, then through a temporary. NoAlias skips the check.
+    template <MatrixExpression E>
+        requires std::is_same_v<OperandElement<E>, T>
+    Matrix& operator=(const E& expr) {
+        if (Shape() == std::pair{expr.Rows(), expr.Columns()} &&
+            CanEvaluateInPlace(expr, Row(0), stride_, rows_, cols_)) {
+            EvaluateExpression(expr, Row(0), stride_, false);
+        } else {
+            *this = Matrix(expr);
+        }
+        return *this;
+    }
+
+    template <MatrixExpression E>
+        requires std::is_same_v<OperandElement<E>, T>
+    Matrix& operator+=(const E& expr) {
+        CheckSameShape(*this, expr);
+        if (CanEvaluateInPlace(expr, Row(0), stride_, rows_, cols_)) {
+            EvaluateExpression(expr, Row(0), stride_, true);
+        } else {
+            *this = Matrix(Lazy(*this) + expr);
+        }
+        return *this;
+    }
+
+    template <MatrixExpression E>
+        requires std::is_same_v<OperandElement<E>, T>
+    Matrix& operator-=(const E& expr) {
+        return *this = Lazy(*this) - expr;
+    }
+
+    // The product goes to a per-thread scratch matrix which then trades buffers with
+    // *this, so repeated products of one shape, as in powers, allocate nothing. Buffers
+    // above kProductScratchBytes are freed right away instead of being kept.
     Matrix& operator*=(const Matrix& rhs) {
-        *this = *this * rhs;
+        Matrix& product = ProductScratch();
+        MultiplyInto(*this, rhs, product);
+        std::swap(*this, product);
+        if (product.data_.size() * sizeof(T) > kProductScratchBytes) {
+            ReleaseProductScratch();
+        }
         return *this;
     }
 
-    struct DefaultParams GetDefaultParams() const override {
+    // Frees the scratch buffer operator*= keeps for the calling thread
+    static void ReleaseProductScratch() {
+        ProductScratch() = Matrix(0, 0);
+    }
+
+    struct DefaultParams GetDefaultParams() const {
         return DefaultParams{Shape()};
     }
 
+    template <typename U>
+    friend void TransposeInPlace(Matrix<U>& matrix);
+
 private:
-    std::vector<std::vector<T>> data_;
+    static Matrix& ProductScratch() {
+        thread_local Matrix product(0, 0);
+        return product;
+    }
+
+    static size_t RowStride(size_t cols) {
+        if constexpr (std::is_arithmetic_v<T> && kCacheLineSize % sizeof(T) == 0) {
+            constexpr size_t kPerLine = kCacheLineSize / sizeof(T);
+            return (cols + kPerLine - 1) / kPerLine * kPerLine;
+        } else {
+            return cols;
+        }
+    }
+
+    template <typename Rows>
+    void CopyRows(const Rows& rows) {
+        size_t i = 0;
+        for (const auto& row : rows) {
+            if (row.size() != cols_) {
+                throw std::runtime_error{"Rows of a matrix must have the same size"};
+            }
+            std::copy(row.begin(), row.end(), Row(i++));
+        }
+    }
+
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    size_t stride_ = 0;
+    std::vector<T, AlignedAllocator<T>> data_;
 };
 
 template <typename T>
 Matrix<T> Transpose(const Matrix<T>& matrix) {
     Matrix<T> transposed(matrix.Columns(), matrix.Rows());
-    for (size_t i = 0; i < transposed.Rows(); ++i) {
-        for (size_t j = 0; j < transposed.Columns(); ++j) {
-            transposed(i, j) = matrix(j, i);
-        }
+    if (matrix.Rows() != 0 && matrix.Columns() != 0) {
+        TransposeBlocked(matrix.Row(0), matrix.Stride(), transposed.Row(0), transposed.Stride(),
+                         matrix.Rows(), matrix.Columns());
     }
     return transposed;
 }
 
+// Square matrices are transposed by recursive block swaps. Other shapes are packed
+// densely, permuted cycle by cycle and spread back to padded rows when the buffer
+// allows, otherwise the rows stay unpadded. Empty matrices get the shape Transpose gives.
+template <typename T>
+void TransposeInPlace(Matrix<T>& matrix) {
+    T* data = matrix.data_.data();
+    size_t rows = matrix.rows_;
+    size_t cols = matrix.cols_;
+    if (rows == 0 || cols == 0) {
+        matrix = Matrix<T>(cols, rows);
+        return;
+    }
+    if (rows == cols) {
+        TransposeSquareInPlace(data, matrix.stride_, rows);
+        return;
+    }
+    // Unpadded rows are already packed; moving them onto themselves would leave moved-from
+    // elements behind
+    if (matrix.stride_ != cols) {
+        for (size_t i = 1; i < rows; ++i) {
+            std::move(data + i * matrix.stride_, data + i * matrix.stride_ + cols,
+                      data + i * cols);
+        }
+    }
+    TransposeCycles(data, rows, cols);
+    std::swap(rows, cols);
+    size_t stride = Matrix<T>::RowStride(cols);
+    if (rows * stride > matrix.data_.size()) {
+        stride = cols;
+    }
+    if (stride != cols) {
+        for (size_t i = rows; i-- > 1;) {
+            std::move_backward(data + i * cols, data + (i + 1) * cols,
+                               data + i * stride + cols);
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            std::fill(data + i * stride + cols, data + (i + 1) * stride, T{});
+        }
+    }
+    matrix.rows_ = rows;
+    matrix.cols_ = cols;
+    matrix.stride_ = stride;
+}
+
+template <typename T>
+struct ring_traits<Matrix<T>> {
+    static Matrix<T> const_like(const Matrix<T>& example, int value) {
+        return Matrix<T>::Constant(example.Rows(), example.Columns(), T(value));
+    }
+
+    static ScaledIdentity<T> lazy_one(const Matrix<T>& example) {
+        return ScaledIdentity<T>(example.Rows(), example.Columns(), GetOne(T{}));
+    }
+
+    static ScaledIdentity<T> lazy_zero(const Matrix<T>& example) {
+        return ScaledIdentity<T>(example.Rows(), example.Columns(), GetZero(T{}));
+    }
+
+    static bool is_zero(const Matrix<T>& x) {
+        for (size_t i = 0; i < x.Rows(); ++i) {
+            if (!std::all_of(x.Row(i), x.Row(i) + x.Columns(), IsZero<T>)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 template <typename T>
 Matrix<T> Identity(size_t n) {
     T one = GetOne(T{});
@@ -127,23 +376,103 @@ Matrix<T> Identity(size_t n) {
     return e;
 }
 
+// Squares of at least this size are checked for symmetry, see SquareSymmetric
+inline constexpr size_t kSymmetricSquareThreshold = 2 * kGemmParallelRows;
+
 template <typename T>
-Matrix<T> operator*(const Matrix<T>& lhs, const Matrix<T>& rhs) {
+bool IsSymmetric(ConstMatrixView<T> matrix) {
+    if (matrix.Rows() != matrix.Columns()) {
+        return false;
+    }
+    for (size_t i = 0; i < matrix.Rows(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            if (!(matrix(i, j) == matrix(j, i))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// res = a * a for a symmetric a over commutative elements. The square is symmetric too,
+// so only the row blocks right of the diagonal are multiplied, about half of the work,
+// and the blocks below are transposed copies.
+template <typename T>
+void SquareSymmetric(ConstMatrixView<T> a, Matrix<T>& res, size_t threads) {
+    size_t n = a.Rows();
+    for (size_t i = 0; i < n; ++i) {
+        std::fill_n(res.Row(i), n, T{});
+    }
+    for (size_t row = 0; row < n; row += kGemmParallelRows) {
+        size_t rows = std::min(kGemmParallelRows, n - row);
+        GemmParallel(a.Block(row, 0, rows, n), a.Block(0, row, n, n - row), res.Row(row) + row,
+                     res.Stride(), threads);
+        TransposeBlocked(res.Row(0) + row, res.Stride(), res.Row(row), res.Stride(), row, rows);
+    }
+}
+
+// res = lhs * rhs without allocating when res already has the right shape.
+// res must not alias lhs or rhs. Large products run on up to threads threads of
+// ThreadPool::Global(), 0 meaning all of them. Squares of large symmetric matrices
+// over commutative elements go through SquareSymmetric.
+template <typename T>
+void MultiplyInto(ConstMatrixView<T> lhs, ConstMatrixView<T> rhs, Matrix<T>& res,
+                  size_t threads = 0) {
     if (lhs.Columns() != rhs.Rows()) {
         throw std::runtime_error{"Not valid dims for multiply matrix"};
     }
-    Matrix<T> rhs_t(Transpose(rhs));
-    Matrix<T> res(lhs.Rows(), rhs.Columns());
-    for (size_t i = 0; i < res.Rows(); ++i) {
-        for (size_t j = 0; j < res.Columns(); ++j) {
-            for (size_t k = 0; k < lhs.Columns(); ++k) {
-                res(i, j) += lhs(i, k) * rhs_t(j, k);
-            }
+    if (res.Rows() != lhs.Rows() || res.Columns() != rhs.Columns()) {
+        res = Matrix<T>(lhs.Rows(), rhs.Columns());
+    }
+    if constexpr (is_commutative<T>::value) {
+        if (lhs.Data() == rhs.Data() && lhs.Shape() == rhs.Shape() &&
+            lhs.RowStride() == rhs.RowStride() && lhs.ColumnStride() == rhs.ColumnStride() &&
+            lhs.Rows() >= kSymmetricSquareThreshold && IsSymmetric(lhs)) {
+            SquareSymmetric(lhs, res, threads);
+            return;
         }
     }
+    if constexpr (is_exact_ring<T>::value) {
+        size_t n = lhs.Rows();
+        if (n >= kStrassenThreshold && lhs.Columns() == n && rhs.Columns() == n &&
+            lhs.ColumnStride() == 1 && rhs.ColumnStride() == 1) {
+            StrassenMultiply(lhs.Data(), lhs.RowStride(), rhs.Data(), rhs.RowStride(), res.Row(0),
+                             res.Stride(), n, threads);
+            return;
+        }
+    }
+    for (size_t i = 0; i < res.Rows(); ++i) {
+        std::fill_n(res.Row(i), res.Columns(), T{});
+    }
+    if (res.Rows() != 0 && res.Columns() != 0) {
+        GemmParallel(lhs, rhs, res.Row(0), res.Stride(), threads);
+    }
+}
+
+template <typename T>
+void MultiplyInto(const Matrix<T>& lhs, const Matrix<T>& rhs, Matrix<T>& res,
+                  size_t threads = 0) {
+    MultiplyInto(lhs.View(), rhs.View(), res, threads);
+}
+
+template <typename T>
+Matrix<T> Multiply(const Matrix<T>& lhs, const Matrix<T>& rhs, size_t threads = 0) {
+    Matrix<T> res(lhs.Rows(), rhs.Columns());
+    MultiplyInto(lhs, rhs, res, threads);
     return res;
 }
 
+// m * m; symmetric matrices only compute half of it, see SquareSymmetric
+template <typename T>
+Matrix<T> Square(const Matrix<T>& matrix, size_t threads = 0) {
+    return Multiply(matrix, matrix, threads);
+}
+
+template <typename T>
+Matrix<T> operator*(const Matrix<T>& lhs, const Matrix<T>& rhs) {
+    return Multiply(lhs, rhs);
+}
+
 template <typename T>
 Matrix<T> operator+(const Matrix<T>& lhs, const Matrix<T>& rhs) {
     Matrix<T> tmp = lhs;
@@ -158,6 +487,17 @@ Matrix<T> operator-(const Matrix<T>& lhs, const Matrix<T>& rhs) {
     return tmp;
 }
 
+template <typename T>
+Matrix<T> operator-(Matrix<T> matrix) {
+    for (size_t i = 0; i < matrix.Rows(); ++i) {
+        T* row = matrix.Row(i);
+        for (size_t j = 0; j < matrix.Columns(); ++j) {
+            row[j] = -row[j];
+        }
+    }
+    return matrix;
+}
+
 template <typename T>
 Matrix<T> operator*(const Matrix<T>& lhs, const T& multiplyer) {
     Matrix<T> tmp = lhs;
@@ -165,7 +505,81 @@ Matrix<T> operator*(const Matrix<T>& lhs, const T& multiplyer) {
     return tmp;
 }
 
+// Temporaries are updated in place and moved out, so a chain like a + b + c + d
+// allocates a single matrix
+template <typename T>
+Matrix<T> operator+(Matrix<T>&& lhs, const Matrix<T>& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
+template <typename T>
+Matrix<T> operator+(const Matrix<T>& lhs, Matrix<T>&& rhs) {
+    rhs += lhs;
+    return std::move(rhs);
+}
+
+template <typename T>
+Matrix<T> operator+(Matrix<T>&& lhs, Matrix<T>&& rhs) {
+    lhs += rhs;
+    return std::move(lhs);
+}
+
+template <typename T>
+Matrix<T> operator-(Matrix<T>&& lhs, const Matrix<T>& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
+}
+
+template <typename T>
+Matrix<T> operator-(const Matrix<T>& lhs, Matrix<T>&& rhs) {
+    for (size_t i = 0; i < rhs.Rows(); ++i) {
+        T* row = rhs.Row(i);
+        const T* lhs_row = lhs.Row(i);
+        for (size_t j = 0; j < rhs.Columns(); ++j) {
+            row[j] = lhs_row[j] - row[j];
+        }
+    }
+    return std::move(rhs);
+}
+
+template <typename T>
+Matrix<T> operator-(Matrix<T>&& lhs, Matrix<T>&& rhs) {
+    lhs -= rhs;
+    return std::move(lhs);
+}
+
+template <typename T>
+Matrix<T> operator*(Matrix<T>&& lhs, const T& multiplyer) {
+    lhs *= multiplyer;
+    return std::move(lhs);
+}
+
+template <typename T>
+struct view_traits {
+    static constexpr bool kView = false;
+};
+
+template <typename T>
+struct view_traits<Matrix<T>> {
+    static constexpr bool kView = false;
+    using Element = T;
+};
+
+template <typename T>
+struct view_traits<MatrixView<T>> {
+    static constexpr bool kView = true;
+    using Element = T;
+};
+
+template <typename T>
+struct view_traits<ConstMatrixView<T>> {
+    static constexpr bool kView = true;
+    using Element = T;
+};
+
 template <typename T, typename U>
+    requires(!view_traits<U>::kView && !MatrixExpression<U>)
 Matrix<T> operator*(const U& multiplyer, const Matrix<T>& rhs) {
     Matrix<T> tmp(rhs.Rows(), rhs.Columns());
     for (size_t i = 0; i < rhs.Rows(); ++i) {
@@ -176,6 +590,81 @@ Matrix<T> operator*(const U& multiplyer, const Matrix<T>& rhs) {
     return tmp;
 }
 
+template <typename T, typename U>
+    requires(!view_traits<U>::kView && !is_matrix<U>::value && !MatrixExpression<U>)
+Matrix<T> operator*(const U& multiplyer, Matrix<T>&& rhs) {
+    for (size_t i = 0; i < rhs.Rows(); ++i) {
+        T* row = rhs.Row(i);
+        for (size_t j = 0; j < rhs.Columns(); ++j) {
+            row[j] = multiplyer * row[j];
+        }
+    }
+    return std::move(rhs);
+}
+
+// Products with a square scalar * I are scalings, additions touch only the diagonal.
+// Other shapes, such as the zero GetLazyZero gives for a rectangular matrix, are built.
+template <typename T>
+void CheckScaledIdentityProduct(size_t inner, const ScaledIdentity<T>& identity, bool on_left) {
+    if (inner != (on_left ? identity.Columns() : identity.Rows())) {
+        throw std::runtime_error{"Not valid dims for multiply matrix"};
+    }
+}
+
+template <typename T>
+Matrix<T> operator*(const Matrix<T>& lhs, const ScaledIdentity<T>& rhs) {
+    CheckScaledIdentityProduct(lhs.Columns(), rhs, false);
+    if (rhs.Rows() != rhs.Columns()) {
+        return lhs * Matrix<T>(rhs);
+    }
+    return lhs * rhs.Scalar();
+}
+
+template <typename T>
+Matrix<T> operator*(Matrix<T>&& lhs, const ScaledIdentity<T>& rhs) {
+    CheckScaledIdentityProduct(lhs.Columns(), rhs, false);
+    if (rhs.Rows() != rhs.Columns()) {
+        return lhs * Matrix<T>(rhs);
+    }
+    return std::move(lhs) * rhs.Scalar();
+}
+
+template <typename T>
+Matrix<T> operator*(const ScaledIdentity<T>& lhs, const Matrix<T>& rhs) {
+    CheckScaledIdentityProduct(rhs.Rows(), lhs, true);
+    if (lhs.Rows() != lhs.Columns()) {
+        return Matrix<T>(lhs) * rhs;
+    }
+    return lhs.Scalar() * rhs;
+}
+
+template <typename T>
+Matrix<T> operator*(const ScaledIdentity<T>& lhs, Matrix<T>&& rhs) {
+    CheckScaledIdentityProduct(rhs.Rows(), lhs, true);
+    if (lhs.Rows() != lhs.Columns()) {
+        return Matrix<T>(lhs) * rhs;
+    }
+    return lhs.Scalar() * std::move(rhs);
+}
+
+template <typename T>
+Matrix<T> operator+(Matrix<T> lhs, const ScaledIdentity<T>& rhs) {
+    lhs += rhs;
+    return lhs;
+}
+
+template <typename T>
+Matrix<T> operator+(const ScaledIdentity<T>& lhs, Matrix<T> rhs) {
+    rhs += lhs;
+    return rhs;
+}
+
+template <typename T>
+Matrix<T> operator-(Matrix<T> lhs, const ScaledIdentity<T>& rhs) {
+    lhs -= rhs;
+    return lhs;
+}
+
 template <typename T>
 bool operator==(const Matrix<T>& a, const Matrix<T>& b) {
     if (a.Rows() != b.Rows()) {
@@ -185,8 +674,23 @@ bool operator==(const Matrix<T>& a, const Matrix<T>& b) {
         return false;
     }
     for (size_t i = 0; i < a.Rows(); ++i) {
-        for (size_t j = 0; j < a.Columns(); ++j) {
-            if (a(i, j) != b(i, j)) {
+        if (!std::equal(a.Row(i), a.Row(i) + a.Columns(), b.Row(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compares without building the scaled identity
+template <typename T>
+bool operator==(const Matrix<T>& matrix, const ScaledIdentity<T>& identity) {
+    if (matrix.Shape() != std::pair{identity.Rows(), identity.Columns()}) {
+        return false;
+    }
+    const T zero = GetZero(identity.Scalar());
+    for (size_t i = 0; i < matrix.Rows(); ++i) {
+        for (size_t j = 0; j < matrix.Columns(); ++j) {
+            if (!(matrix(i, j) == (i == j ? identity.Scalar() : zero))) {
                 return false;
             }
         }
@@ -204,3 +708,72 @@ std::ostream& operator<<(std::ostream& os, const Matrix<T>& matrix) {
     }
     return os;
 }
+
+template <typename T>
+ConstMatrixView<T> TransposedView(const Matrix<T>& matrix) {
+    return matrix.View().Transposed();
+}
+
+// Operators taking at least one view; Matrix operands are viewed in place
+template <typename L, typename R>
+concept ViewOperands =
+    requires {
+        typename view_traits<L>::Element;
+        typename view_traits<R>::Element;
+    } && std::is_same_v<typename view_traits<L>::Element, typename view_traits<R>::Element> &&
+    (view_traits<L>::kView || view_traits<R>::kView);
+
+template <typename L, typename R>
+    requires ViewOperands<L, R>
+Matrix<typename view_traits<L>::Element> operator+(const L& lhs, const R& rhs) {
+    using T = typename view_traits<L>::Element;
+    Matrix<T> res{ConstMatrixView<T>(lhs)};
+    res.View() += ConstMatrixView<T>(rhs);
+    return res;
+}
+
+template <typename L, typename R>
+    requires ViewOperands<L, R>
+Matrix<typename view_traits<L>::Element> operator-(const L& lhs, const R& rhs) {
+    using T = typename view_traits<L>::Element;
+    Matrix<T> res{ConstMatrixView<T>(lhs)};
+    res.View() -= ConstMatrixView<T>(rhs);
+    return res;
+}
+
+template <typename L, typename R>
+    requires ViewOperands<L, R>
+Matrix<typename view_traits<L>::Element> operator*(const L& lhs, const R& rhs) {
+    using T = typename view_traits<L>::Element;
+    Matrix<T> res(lhs.Rows(), rhs.Columns());
+    MultiplyInto<T>(lhs, rhs, res);
+    return res;
+}
+
+template <typename L, typename R>
+    requires ViewOperands<L, R>
+bool operator==(const L& lhs, const R& rhs) {
+    if (lhs.Rows() != rhs.Rows() || lhs.Columns() != rhs.Columns()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.Rows(); ++i) {
+        for (size_t j = 0; j < lhs.Columns(); ++j) {
+            if (lhs(i, j) != rhs(i, j)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename V>
+    requires(view_traits<V>::kView)
+std::ostream& operator<<(std::ostream& os, const V& view) {
+    for (size_t row = 0; row < view.Rows(); ++row) {
+        for (size_t col = 0; col < view.Columns(); ++col) {
+            os << view(row, col) << ' ';
+        }
+        os << '\n';
+    }
+    return os;
+}
@@ -0,0 +1,583 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "gemm.h"
+#include "matrix_view.h"
+#include "mp_fwd.h"  // Forward declaration
+
+// Lazy matrix arithmetic. Operators on an expression build a small tree instead of
+// matrices, and assigning the tree to a Matrix evaluates it with one fused loop over the
+// destination plus one accumulating GEMM per product:
+//
+//   Matrix<double> r = Lazy(a) + Lazy(b) * s - c;  // one pass over r
+//   r = Lazy(a) * b + c;  // r = c, then r += a * b by GemmParallel
+//
+// Expressions are opt-in: start one with Lazy(m), which also accepts views. Products
+// may only be added, and their operands are matrices or views; other operands are
+// evaluated into a matrix first.
+//
+// Every node has Rows() and Columns() and
+//   At(i, j)              - element (i, j) of the elementwise part, if kElementwise
+//   ForEachProduct(f)     - calls f(lhs, rhs) with the views of every product
+//   ForEachOperand(f)     - calls f(view, product) for every leaf, telling whether it is
+//                           an operand of a product
+//
+// Matrix operands are referenced, temporaries are moved into the expression. An
+// expression kept in a variable must not outlive the matrices it refers to.
+
+template <typename T>
+class MatrixView;
+
+template <typename T>
+class ConstMatrixView;
+
+template <typename T>
+struct is_matrix_expression : std::false_type {};
+
+template <typename T>
+concept MatrixExpression = is_matrix_expression<std::remove_cvref_t<T>>::value;
+
+// Element type of anything an expression operator accepts
+template <typename T>
+struct matrix_operand {};
+
+template <typename T>
+struct matrix_operand<Matrix<T>> {
+    using Element = T;
+};
+
+template <typename T>
+struct matrix_operand<ConstMatrixView<T>> {
+    using Element = T;
+};
+
+template <typename T>
+struct matrix_operand<MatrixView<T>> {
+    using Element = T;
+};
+
+template <typename T>
+    requires MatrixExpression<T>
+struct matrix_operand<T> {
+    using Element = typename T::Element;
+};
+
+template <typename T>
+using OperandElement = typename matrix_operand<std::remove_cvref_t<T>>::Element;
+
+template <typename T>
+concept MatrixOperand = requires { typename OperandElement<T>; };
+
+// Matrix taken by reference
+template <typename T>
+class MatrixRef {
+public:
+    using Element = T;
+    static constexpr bool kElementwise = true;
+    static constexpr bool kProducts = false;
+
+    explicit MatrixRef(const Matrix<T>& matrix) : matrix_(&matrix) {
+    }
+
+    size_t Rows() const {
+        return matrix_->Rows();
+    }
+
+    size_t Columns() const {
+        return matrix_->Columns();
+    }
+
+    const T& At(size_t i, size_t j) const {
+        return matrix_->Row(i)[j];
+    }
+
+    ConstMatrixView<T> View() const {
+        return matrix_->View();
+    }
+
+    template <typename F>
+    void ForEachProduct(F&&) const {
+    }
+
+    template <typename F>
+    void ForEachOperand(F&& f, bool product = false) const {
+        f(View(), product);
+    }
+
+private:
+    const Matrix<T>* matrix_;
+};
+
+// Temporary matrix owned by the expression
+template <typename T>
+class MatrixValue {
+public:
+    using Element = T;
+    static constexpr bool kElementwise = true;
+    static constexpr bool kProducts = false;
+
+    explicit MatrixValue(Matrix<T>&& matrix) : matrix_(std::move(matrix)) {
+    }
+
+    size_t Rows() const {
+        return matrix_.Rows();
+    }
+
+    size_t Columns() const {
+        return matrix_.Columns();
+    }
+
+    const T& At(size_t i, size_t j) const {
+        return matrix_.Row(i)[j];
+    }
+
+    ConstMatrixView<T> View() const {
+        return matrix_.View();
+    }
+
+    template <typename F>
+    void ForEachProduct(F&&) const {
+    }
+
+    template <typename F>
+    void ForEachOperand(F&&, bool = false) const {
+        // Owned storage cannot alias a destination
+    }
+
+private:
+    Matrix<T> matrix_;
+};
+
+template <typename T>
+class ViewRef {
+public:
+    using Element = T;
+    static constexpr bool kElementwise = true;
+    static constexpr bool kProducts = false;
+
+    explicit ViewRef(ConstMatrixView<T> view) : view_(view) {
+    }
+
+    size_t Rows() const {
+        return view_.Rows();
+    }
+
+    size_t Columns() const {
+        return view_.Columns();
+    }
+
+    const T& At(size_t i, size_t j) const {
+        return view_(i, j);
+    }
+
+    ConstMatrixView<T> View() const {
+        return view_;
+    }
+
+    template <typename F>
+    void ForEachProduct(F&&) const {
+    }
+
+    template <typename F>
+    void ForEachOperand(F&& f, bool product = false) const {
+        f(view_, product);
+    }
+
+private:
+    ConstMatrixView<T> view_;
+};
+
+template <typename L, typename R>
+void CheckSameShape(const L& lhs, const R& rhs) {
+    if (lhs.Rows() != rhs.Rows() || lhs.Columns() != rhs.Columns()) {
+        throw std::runtime_error{"Matrices have different shapes"};
+    }
+}
+
+template <typename L, typename R>
+class MatrixSum {
+public:
+    using Element = typename L::Element;
+    static constexpr bool kElementwise = L::kElementwise || R::kElementwise;
+    static constexpr bool kProducts = L::kProducts || R::kProducts;
+
+    MatrixSum(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+        CheckSameShape(lhs_, rhs_);
+    }
+
+    size_t Rows() const {
+        return lhs_.Rows();
+    }
+
+    size_t Columns() const {
+        return lhs_.Columns();
+    }
+
+    Element At(size_t i, size_t j) const {
+        if constexpr (L::kElementwise && R::kElementwise) {
+            return lhs_.At(i, j) + rhs_.At(i, j);
+        } else if constexpr (L::kElementwise) {
+            return lhs_.At(i, j);
+        } else {
+            return rhs_.At(i, j);
+        }
+    }
+
+    template <typename F>
+    void ForEachProduct(F&& f) const {
+        lhs_.ForEachProduct(f);
+        rhs_.ForEachProduct(f);
+    }
+
+    template <typename F>
+    void ForEachOperand(F&& f, bool product = false) const {
+        lhs_.ForEachOperand(f, product);
+        rhs_.ForEachOperand(f, product);
+    }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+template <typename L, typename R>
+class MatrixDifference {
+public:
+    using Element = typename L::Element;
+    static constexpr bool kElementwise = true;
+    static constexpr bool kProducts = L::kProducts;
+    static_assert(!R::kProducts, "Products in a matrix expression may only be added");
+
+    MatrixDifference(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+        CheckSameShape(lhs_, rhs_);
+    }
+
+    size_t Rows() const {
+        return lhs_.Rows();
+    }
+
+    size_t Columns() const {
+        return lhs_.Columns();
+    }
+
+    Element At(size_t i, size_t j) const {
+        if constexpr (L::kElementwise) {
+            return lhs_.At(i, j) - rhs_.At(i, j);
+        } else {
+            return Element{} - rhs_.At(i, j);
+        }
+    }
+
+    template <typename F>
+    void ForEachProduct(F&& f) const {
+        lhs_.ForEachProduct(f);
+    }
+
+    template <typename F>
+    void ForEachOperand(F&& f, bool product = false) const {
+        lhs_.ForEachOperand(f, product);
+        rhs_.ForEachOperand(f, product);
+    }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+// Multiplication by a scalar, which stays on the side it was written on
+template <typename E, typename U, bool kScalarFirst>
+class MatrixScaled {
+public:
+    using Element = typename E::Element;
+    static constexpr bool kElementwise = true;
+    static constexpr bool kProducts = false;
+    static_assert(!E::kProducts, "Products in a matrix expression may only be added");
+
+    MatrixScaled(E expr, U multiplyer)
+        : expr_(std::move(expr)), multiplyer_(std::move(multiplyer)) {
+    }
+
+    size_t Rows() const {
+        return expr_.Rows();
+    }
+
+    size_t Columns() const {
+        return expr_.Columns();
+    }
+
+    Element At(size_t i, size_t j) const {
+        if constexpr (kScalarFirst) {
+            return multiplyer_ * expr_.At(i, j);
+        } else {
+            return expr_.At(i, j) * multiplyer_;
+        }
+    }
+
+    template <typename F>
+    void ForEachProduct(F&&) const {
+    }
+
+    template <typename F>
+    void ForEachOperand(F&& f, bool product = false) const {
+        expr_.ForEachOperand(f, product);
+    }
+
+private:
+    E expr_;
+    U multiplyer_;
+};
+
+// lhs * rhs of two leaves, accumulated into the destination by GemmParallel
+template <typename L, typename R>
+class MatrixProduct {
+public:
+    using Element = typename L::Element;
+    static constexpr bool kElementwise = false;
+    static constexpr bool kProducts = true;
+
+    MatrixProduct(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+        if (lhs_.Columns() != rhs_.Rows()) {
+            throw std::runtime_error{"Not valid dims for multiply matrix"};
+        }
+    }
+
+    size_t Rows() const {
+        return lhs_.Rows();
+    }
+
+    size_t Columns() const {
+        return rhs_.Columns();
+    }
+
+    template <typename F>
+    void ForEachProduct(F&& f) const {
+        f(lhs_.View(), rhs_.View());
+    }
+
+    template <typename F>
+    void ForEachOperand(F&& f, bool = false) const {
+        lhs_.ForEachOperand(f, true);
+        rhs_.ForEachOperand(f, true);
+    }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+template <typename T>
+struct is_matrix_expression<MatrixRef<T>> : std::true_type {};
+
+template <typename T>
+struct is_matrix_expression<MatrixValue<T>> : std::true_type {};
+
+template <typename T>
+struct is_matrix_expression<ViewRef<T>> : std::true_type {};
+
+template <typename L, typename R>
+struct is_matrix_expression<MatrixSum<L, R>> : std::true_type {};
+
+template <typename L, typename R>
+struct is_matrix_expression<MatrixDifference<L, R>> : std::true_type {};
+
+template <typename E, typename U, bool kScalarFirst>
+struct is_matrix_expression<MatrixScaled<E, U, kScalarFirst>> : std::true_type {};
+
+template <typename L, typename R>
+struct is_matrix_expression<MatrixProduct<L, R>> : std::true_type {};
+
+template <typename T>
+MatrixRef<T> Lazy(const Matrix<T>& matrix) {
+    return MatrixRef<T>(matrix);
+}
+
+template <typename T>
+ViewRef<T> Lazy(ConstMatrixView<T> view) {
+    return ViewRef<T>(view);
+}
+
+template <typename T>
+ViewRef<T> Lazy(MatrixView<T> view) {
+    return ViewRef<T>(view);
+}
+
+template <typename X>
+auto AsMatrixExpression(X&& operand) {
+    using D = std::remove_cvref_t<X>;
+    using T = OperandElement<X>;
+    if constexpr (MatrixExpression<D>) {
+        return D(std::forward<X>(operand));
+    } else if constexpr (!is_matrix<D>::value) {
+        return ViewRef<T>(operand);
+    } else if constexpr (std::is_rvalue_reference_v<X&&>) {
+        return MatrixValue<T>(std::move(operand));
+    } else {
+        return MatrixRef<T>(operand);
+    }
+}
+
+// Operands of a product must be stored, anything else is evaluated first
+template <typename X>
+auto AsProductOperand(X&& operand) {
+    auto expr = AsMatrixExpression(std::forward<X>(operand));
+    using E = decltype(expr);
+    using T = typename E::Element;
+    if constexpr (std::is_same_v<E, MatrixRef<T>> || std::is_same_v<E, MatrixValue<T>> ||
+                  std::is_same_v<E, ViewRef<T>>) {
+        return expr;
+    } else {
+        return MatrixValue<T>(Matrix<T>(expr));
+    }
+}
+
+// At least one expression, the other one may be a matrix or a view, same elements
+template <typename L, typename R>
+concept MatrixExpressionOperands = (MatrixExpression<L> || MatrixExpression<R>) &&
+                                   MatrixOperand<L> && MatrixOperand<R> &&
+                                   std::is_same_v<OperandElement<L>, OperandElement<R>>;
+
+// Scalars whose product with the elements keeps their type, kScalarFirst tells on
+// which side the scalar is
+template <typename U, typename E, bool kScalarFirst>
+concept MatrixExpressionScalar =
+    !MatrixOperand<U> &&
+    ((kScalarFirst &&
+      std::is_same_v<MultiplyType<const U&, const OperandElement<E>&>, OperandElement<E>>) ||
+     (!kScalarFirst &&
+      std::is_same_v<MultiplyType<const OperandElement<E>&, const U&>, OperandElement<E>>));
+
+template <typename L, typename R>
+    requires MatrixExpressionOperands<L, R>
+auto operator+(L&& lhs, R&& rhs) {
+    return MatrixSum(AsMatrixExpression(std::forward<L>(lhs)),
+                     AsMatrixExpression(std::forward<R>(rhs)));
+}
+
+template <typename L, typename R>
+    requires MatrixExpressionOperands<L, R>
+auto operator-(L&& lhs, R&& rhs) {
+    return MatrixDifference(AsMatrixExpression(std::forward<L>(lhs)),
+                            AsMatrixExpression(std::forward<R>(rhs)));
+}
+
+template <typename L, typename R>
+    requires MatrixExpressionOperands<L, R>
+auto operator*(L&& lhs, R&& rhs) {
+    return MatrixProduct(AsProductOperand(std::forward<L>(lhs)),
+                         AsProductOperand(std::forward<R>(rhs)));
+}
+
+template <typename U, MatrixExpression E>
+    requires MatrixExpressionScalar<U, E, true>
+auto operator*(const U& multiplyer, E&& expr) {
+    return MatrixScaled<std::remove_cvref_t<E>, U, true>(AsMatrixExpression(std::forward<E>(expr)),
+                                                          multiplyer);
+}
+
+template <MatrixExpression E, typename U>
+    requires MatrixExpressionScalar<U, E, false>
+auto operator*(E&& expr, const U& multiplyer) {
+    return MatrixScaled<std::remove_cvref_t<E>, U, false>(AsMatrixExpression(std::forward<E>(expr)),
+                                                           multiplyer);
+}
+
+// out = expr, or out += expr when accumulating, for out with the shape of expr and
+// row stride ld. Operands must not overlap out, except elementwise ones that read
+// exactly the element being written.
+template <typename E, typename T>
+void EvaluateExpression(const E& expr, T* out, size_t ld, bool accumulate) {
+    size_t rows = expr.Rows();
+    size_t cols = expr.Columns();
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        T* row = out + i * ld;
+        if constexpr (!E::kElementwise) {
+            if (!accumulate) {
+                std::fill_n(row, cols, T{});
+            }
+        } else if (accumulate) {
+            for (size_t j = 0; j < cols; ++j) {
+                row[j] += expr.At(i, j);
+            }
+        } else {
+            for (size_t j = 0; j < cols; ++j) {
+                row[j] = expr.At(i, j);
+            }
+        }
+    }
+    expr.ForEachProduct([out, ld](ConstMatrixView<T> lhs, ConstMatrixView<T> rhs) {
+        GemmParallel(lhs, rhs, out, ld);
+    });
+}
+
+// Whether expr can be evaluated straight into rows x cols at out with row stride ld:
+// no product operand overlaps it, and elementwise operands either do not overlap it or
+// are the destination itself
+template <typename E, typename T>
+bool CanEvaluateInPlace(const E& expr, const T* out, size_t ld, size_t rows, size_t cols) {
+    if (rows == 0 || cols == 0) {
+        return true;
+    }
+    std::less<const T*> less;
+    const T* out_end = out + (rows - 1) * ld + cols;
+    bool safe = true;
+    expr.ForEachOperand([&](ConstMatrixView<T> view, bool product) {
+        if (view.Rows() == 0 || view.Columns() == 0) {
+            return;
+        }
+        const T* begin = view.Data();
+        const T* end = begin + (view.Rows() - 1) * view.RowStride() +
+                       (view.Columns() - 1) * view.ColumnStride() + 1;
+        if (!less(begin, out_end) || !less(out, end)) {
+            return;
+        }
+        bool same = begin == out && view.RowStride() == ld && view.ColumnStride() == 1;
+        if (product || !same) {
+            safe = false;
+        }
+    });
+    return safe;
+}
+
+// Assignment target that promises its operands do not overlap it, so expressions are
+// evaluated straight into it without checking. Obtained from NoAlias(matrix).
+template <typename T>
+class NoAliasMatrix {
+public:
+    explicit NoAliasMatrix(Matrix<T>& matrix) : matrix_(matrix) {
+    }
+
+    template <MatrixExpression E>
+        requires std::is_same_v<OperandElement<E>, T>
+    Matrix<T>& operator=(const E& expr) {
+        if (matrix_.Rows() != expr.Rows() || matrix_.Columns() != expr.Columns()) {
+            matrix_ = Matrix<T>(expr.Rows(), expr.Columns());
+        }
+        EvaluateExpression(expr, matrix_.Row(0), matrix_.Stride(), false);
+        return matrix_;
+    }
+
+    template <MatrixExpression E>
+        requires std::is_same_v<OperandElement<E>, T>
+    Matrix<T>& operator+=(const E& expr) {
+        CheckSameShape(matrix_, expr);
+        EvaluateExpression(expr, matrix_.Row(0), matrix_.Stride(), true);
+        return matrix_;
+    }
+
+private:
+    Matrix<T>& matrix_;
+};
+
+template <typename T>
+NoAliasMatrix<T> NoAlias(Matrix<T>& matrix) {
+    return NoAliasMatrix<T>(matrix);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+// Non-owning window into matrix storage: element (i, j) lives at
+// data[i * row_stride + j * col_stride]. Blocks and transposes of a view are views of
+// the same memory, so nothing is copied. The viewed matrix must outlive the view.
+template <typename T>
+class ConstMatrixView {
+public:
+    ConstMatrixView(const T* data, size_t rows, size_t cols, size_t row_stride,
+                    size_t col_stride = 1)
+        : data_(data), rows_(rows), cols_(cols), row_stride_(row_stride), col_stride_(col_stride) {
+    }
+
+    std::pair<size_t, size_t> Shape() const {
+        return {rows_, cols_};
+    }
+
+    size_t Rows() const {
+        return rows_;
+    }
+
+    size_t Columns() const {
+        return cols_;
+    }
+
+    size_t RowStride() const {
+        return row_stride_;
+    }
+
+    size_t ColumnStride() const {
+        return col_stride_;
+    }
+
+    const T* Data() const {
+        return data_;
+    }
+
+    const T& operator()(size_t i, size_t j) const {
+        return data_[i * row_stride_ + j * col_stride_];
+    }
+
+    ConstMatrixView Block(size_t row, size_t col, size_t rows, size_t cols) const {
+        if (row + rows > rows_ || col + cols > cols_) {
+            throw std::runtime_error{"Block is out of the matrix"};
+        }
+        return {data_ + row * row_stride_ + col * col_stride_, rows, cols, row_stride_,
+                col_stride_};
+    }
+
+    ConstMatrixView Transposed() const {
+        return {data_, cols_, rows_, col_stride_, row_stride_};
+    }
+
+private:
+    const T* data_;
+    size_t rows_;
+    size_t cols_;
+    size_t row_stride_;
+    size_t col_stride_;
+};
+
+// Mutable counterpart of ConstMatrixView. Copying a view copies the reference, use
+// Assign to copy elements into the viewed block.
+template <typename T>
+class MatrixView {
+public:
+    MatrixView(T* data, size_t rows, size_t cols, size_t row_stride, size_t col_stride = 1)
+        : data_(data), rows_(rows), cols_(cols), row_stride_(row_stride), col_stride_(col_stride) {
+    }
+
+    operator ConstMatrixView<T>() const {
+        return {data_, rows_, cols_, row_stride_, col_stride_};
+    }
+
+    std::pair<size_t, size_t> Shape() const {
+        return {rows_, cols_};
+    }
+
+    size_t Rows() const {
+        return rows_;
+    }
+
+    size_t Columns() const {
+        return cols_;
+    }
+
+    size_t RowStride() const {
+        return row_stride_;
+    }
+
+    size_t ColumnStride() const {
+        return col_stride_;
+    }
+
+    T* Data() const {
+        return data_;
+    }
+
+    T& operator()(size_t i, size_t j) const {
+        return data_[i * row_stride_ + j * col_stride_];
+    }
+
+    MatrixView Block(size_t row, size_t col, size_t rows, size_t cols) const {
+        if (row + rows > rows_ || col + cols > cols_) {
+            throw std::runtime_error{"Block is out of the matrix"};
+        }
+        return {data_ + row * row_stride_ + col * col_stride_, rows, cols, row_stride_,
+                col_stride_};
+    }
+
+    MatrixView Transposed() const {
+        return {data_, cols_, rows_, col_stride_, row_stride_};
+    }
+
+    const MatrixView& Assign(ConstMatrixView<T> rhs) const {
+        CheckShape(rhs);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j) {
+                (*this)(i, j) = rhs(i, j);
+            }
+        }
+        return *this;
+    }
+
+    const MatrixView& operator+=(ConstMatrixView<T> rhs) const {
+        CheckShape(rhs);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j) {
+                (*this)(i, j) += rhs(i, j);
+            }
+        }
+        return *this;
+    }
+
+    const MatrixView& operator-=(ConstMatrixView<T> rhs) const {
+        CheckShape(rhs);
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j) {
+                (*this)(i, j) -= rhs(i, j);
+            }
+        }
+        return *this;
+    }
+
+    const MatrixView& operator*=(const T& multiplyer) const {
+        for (size_t i = 0; i < rows_; ++i) {
+            for (size_t j = 0; j < cols_; ++j) {
+                (*this)(i, j) *= multiplyer;
+            }
+        }
+        return *this;
+    }
+
+private:
+    void CheckShape(const ConstMatrixView<T>& rhs) const {
+        if (rhs.Rows() != rows_ || rhs.Columns() != cols_) {
+            throw std::runtime_error{"Views have different shapes"};
+        }
+    }
+
+    T* data_;
+    size_t rows_;
+    size_t cols_;
+    size_t row_stride_;
+    size_t col_stride_;
+};
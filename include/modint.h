@@ -0,0 +1,424 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "lazy_reduction.h"
+#include "mp_fwd.h"  // Forward declaration
+
+constexpr bool IsPrime(uint32_t value) {
+    if (value < 2) {
+        return false;
+    }
+    for (uint32_t div = 2; static_cast<uint64_t>(div) * div <= value; ++div) {
+        if (value % div == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr uint32_t PowMod(uint64_t base, uint64_t pow, uint32_t mod) {
+    uint64_t res = 1 % mod;
+    base %= mod;
+    while (pow > 0) {
+        if (pow & 1) {
+            res = res * base % mod;
+        }
+        base = base * base % mod;
+        pow >>= 1;
+    }
+    return static_cast<uint32_t>(res);
+}
+
+// Smallest generator of the multiplicative group modulo a prime
+constexpr uint32_t PrimitiveRoot(uint32_t prime) {
+    if (prime == 2) {
+        return 1;
+    }
+    uint32_t factors[32] = {};
+    size_t count = 0;
+    uint32_t rest = prime - 1;
+    for (uint32_t div = 2; static_cast<uint64_t>(div) * div <= rest; ++div) {
+        if (rest % div == 0) {
+            factors[count++] = div;
+            while (rest % div == 0) {
+                rest /= div;
+            }
+        }
+    }
+    if (rest > 1) {
+        factors[count++] = rest;
+    }
+    for (uint32_t root = 2;; ++root) {
+        bool generator = true;
+        for (size_t i = 0; i < count && generator; ++i) {
+            generator = PowMod(root, (prime - 1) / factors[i], prime) != 1;
+        }
+        if (generator) {
+            return root;
+        }
+    }
+}
+
+// Inverse of an odd value modulo 2^32 by Newton's iteration, each step doubling the
+// number of correct low bits
+constexpr uint32_t InverseMod2To32(uint32_t odd) {
+    uint32_t inverse = odd;
+    for (int i = 0; i < 4; ++i) {
+        inverse *= 2 - odd * inverse;
+    }
+    return inverse;
+}
+
+// Integer modulo P, P < 2^31 so that sums of two residues fit into uint32_t. Odd moduli
+// keep residues in Montgomery form, value * 2^32 mod P, where a product is reduced by two
+// multiplications instead of a division; even ones keep the value itself.
+template <uint32_t P>
+class ModInt {
+    static_assert(P >= 1 && P < (1u << 31), "Modulus must be in [1, 2^31)");
+
+public:
+    static constexpr uint32_t kModulus = P;
+
+    ModInt() = default;
+
+    ModInt(int64_t value) {
+        value %= static_cast<int64_t>(P);
+        auto residue = static_cast<uint32_t>(value < 0 ? value + P : value);
+        if constexpr (kMontgomery) {
+            value_ = Reduce(static_cast<uint64_t>(residue) * kR2);
+        } else {
+            value_ = residue;
+        }
+    }
+
+    uint32_t Value() const {
+        if constexpr (kMontgomery) {
+            return Reduce(value_);
+        } else {
+            return value_;
+        }
+    }
+
+    ModInt& operator+=(const ModInt& rhs) {
+        value_ += rhs.value_;
+        if (value_ >= P) {
+            value_ -= P;
+        }
+        return *this;
+    }
+
+    ModInt& operator-=(const ModInt& rhs) {
+        value_ += P - rhs.value_;
+        if (value_ >= P) {
+            value_ -= P;
+        }
+        return *this;
+    }
+
+    ModInt& operator*=(const ModInt& rhs) {
+        if constexpr (kMontgomery) {
+            value_ = Reduce(static_cast<uint64_t>(value_) * rhs.value_);
+        } else {
+            value_ = static_cast<uint32_t>(static_cast<uint64_t>(value_) * rhs.value_ % P);
+        }
+        return *this;
+    }
+
+    ModInt& operator/=(const ModInt& rhs) {
+        return *this *= rhs.Inverse();
+    }
+
+    ModInt operator-() const {
+        return ModInt() - *this;
+    }
+
+    ModInt Pow(uint64_t pow) const {
+        ModInt res(1);
+        for (ModInt base = *this; pow > 0; pow >>= 1) {
+            if (pow & 1) {
+                res *= base;
+            }
+            base *= base;
+        }
+        return res;
+    }
+
+    // Only valid for prime P
+    ModInt Inverse() const {
+        return Pow(P - 2);
+    }
+
+    friend ModInt operator+(ModInt lhs, const ModInt& rhs) {
+        return lhs += rhs;
+    }
+
+    friend ModInt operator-(ModInt lhs, const ModInt& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend ModInt operator*(ModInt lhs, const ModInt& rhs) {
+        return lhs *= rhs;
+    }
+
+    friend ModInt operator/(ModInt lhs, const ModInt& rhs) {
+        return lhs /= rhs;
+    }
+
+    friend bool operator==(const ModInt& lhs, const ModInt& rhs) {
+        return lhs.value_ == rhs.value_;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const ModInt& num) {
+        return os << num.Value();
+    }
+
+private:
+    friend struct lazy_reduction<ModInt>;
+
+    static constexpr bool kMontgomery = P % 2 == 1 && P > 1;
+
+    // P^-1 mod 2^32 and 2^64 mod P
+    static constexpr uint32_t kInverse = kMontgomery ? InverseMod2To32(P) : 0;
+    static constexpr uint32_t kR2 = static_cast<uint32_t>((UINT64_MAX % P + 1) % P);
+
+    // value * 2^-32 mod P for value < P * 2^32: value and m * P share their low half, so
+    // the difference of the high halves is the result, off by P when negative
+    static uint32_t Reduce(uint64_t value) {
+        uint32_t m = static_cast<uint32_t>(value) * kInverse;
+        auto high = static_cast<uint32_t>(value >> 32);
+        auto correction = static_cast<uint32_t>((static_cast<uint64_t>(m) * P) >> 32);
+        return high - correction + (high < correction ? P : 0);
+    }
+
+    uint32_t value_ = 0;
+};
+
+template <uint32_t P>
+struct has_exact_division<ModInt<P>> : std::bool_constant<(P > 3 && IsPrime(P))> {};
+
+template <uint32_t P>
+struct is_exact_ring<ModInt<P>> : std::true_type {};
+
+template <uint32_t P>
+struct is_commutative<ModInt<P>> : std::true_type {};
+
+// Sums of products of Montgomery residues are value * 2^64, one Reduce brings them back
+// to Montgomery form
+template <uint32_t P>
+struct lazy_reduction<ModInt<P>> {
+    static constexpr bool kEnabled = P > 1;
+    static constexpr size_t kTerms = LazyTerms(P);
+
+    static uint32_t Raw(const ModInt<P>& value) {
+        return value.value_;
+    }
+
+    static constexpr uint32_t Modulus() {
+        return P;
+    }
+
+    static constexpr size_t Terms() {
+        return kTerms;
+    }
+
+    static uint64_t Fold(uint64_t sum) {
+        return sum % P;
+    }
+
+    static ModInt<P> FromSum(uint64_t sum) {
+        ModInt<P> res;
+        if constexpr (ModInt<P>::kMontgomery) {
+            res.value_ = ModInt<P>::Reduce(sum % P);
+        } else {
+            res.value_ = static_cast<uint32_t>(sum % P);
+        }
+        return res;
+    }
+};
+
+// Reduction modulo a runtime modulus m in [2, 2^31) by one 128-bit multiplication: with
+// inverse = ceil(2^64 / m), floor(z * inverse / 2^64) is z / m or one more for every
+// 64-bit z, and the remainder is corrected by one conditional addition
+class BarrettReduction {
+public:
+    explicit BarrettReduction(uint32_t modulus)
+        : modulus_(modulus), inverse_(UINT64_MAX / modulus + 1) {
+    }
+
+    uint32_t Modulus() const {
+        return modulus_;
+    }
+
+    uint32_t Reduce(uint64_t value) const {
+        auto quotient = static_cast<uint64_t>((static_cast<Uint128>(value) * inverse_) >> 64);
+        uint64_t product = quotient * modulus_;
+        return static_cast<uint32_t>(value - product + (value < product ? modulus_ : 0));
+    }
+
+private:
+    __extension__ using Uint128 = unsigned __int128;
+
+    uint32_t modulus_;
+    uint64_t inverse_;
+};
+
+// Integer modulo a runtime modulus shared by every value with the same Id. SetModulus
+// must be called before any value is made and not while other threads compute with
+// them; products are reduced by BarrettReduction.
+template <int Id>
+class DynamicModInt {
+public:
+    static void SetModulus(uint32_t modulus) {
+        if (modulus < 2 || modulus >= (1u << 31)) {
+            throw std::runtime_error{"Modulus must be in [2, 2^31)"};
+        }
+        barrett_ = BarrettReduction(modulus);
+        terms_ = LazyTerms(modulus);
+    }
+
+    static uint32_t Modulus() {
+        return barrett_.Modulus();
+    }
+
+    DynamicModInt() = default;
+
+    DynamicModInt(int64_t value) {
+        auto modulus = static_cast<int64_t>(Modulus());
+        value %= modulus;
+        value_ = static_cast<uint32_t>(value < 0 ? value + modulus : value);
+    }
+
+    uint32_t Value() const {
+        return value_;
+    }
+
+    DynamicModInt& operator+=(const DynamicModInt& rhs) {
+        value_ += rhs.value_;
+        if (value_ >= Modulus()) {
+            value_ -= Modulus();
+        }
+        return *this;
+    }
+
+    DynamicModInt& operator-=(const DynamicModInt& rhs) {
+        value_ += Modulus() - rhs.value_;
+        if (value_ >= Modulus()) {
+            value_ -= Modulus();
+        }
+        return *this;
+    }
+
+    DynamicModInt& operator*=(const DynamicModInt& rhs) {
+        value_ = barrett_.Reduce(static_cast<uint64_t>(value_) * rhs.value_);
+        return *this;
+    }
+
+    DynamicModInt& operator/=(const DynamicModInt& rhs) {
+        return *this *= rhs.Inverse();
+    }
+
+    DynamicModInt operator-() const {
+        return DynamicModInt() - *this;
+    }
+
+    DynamicModInt Pow(uint64_t pow) const {
+        DynamicModInt res(1);
+        for (DynamicModInt base = *this; pow > 0; pow >>= 1) {
+            if (pow & 1) {
+                res *= base;
+            }
+            base *= base;
+        }
+        return res;
+    }
+
+    // Extended Euclid, so the modulus need not be prime as long as value is coprime to it
+    DynamicModInt Inverse() const {
+        int64_t a = value_;
+        int64_t b = Modulus();
+        int64_t x = 1;
+        int64_t y = 0;
+        while (b != 0) {
+            int64_t q = a / b;
+            a = std::exchange(b, a - q * b);
+            x = std::exchange(y, x - q * y);
+        }
+        if (a != 1) {
+            throw std::runtime_error{"Value is not invertible"};
+        }
+        return DynamicModInt(x);
+    }
+
+    friend DynamicModInt operator+(DynamicModInt lhs, const DynamicModInt& rhs) {
+        return lhs += rhs;
+    }
+
+    friend DynamicModInt operator-(DynamicModInt lhs, const DynamicModInt& rhs) {
+        return lhs -= rhs;
+    }
+
+    friend DynamicModInt operator*(DynamicModInt lhs, const DynamicModInt& rhs) {
+        return lhs *= rhs;
+    }
+
+    friend DynamicModInt operator/(DynamicModInt lhs, const DynamicModInt& rhs) {
+        return lhs /= rhs;
+    }
+
+    friend bool operator==(const DynamicModInt& lhs, const DynamicModInt& rhs) {
+        return lhs.value_ == rhs.value_;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const DynamicModInt& num) {
+        return os << num.value_;
+    }
+
+private:
+    friend struct lazy_reduction<DynamicModInt>;
+
+    inline static BarrettReduction barrett_{2};
+    inline static size_t terms_ = LazyTerms(2);
+
+    uint32_t value_ = 0;
+};
+
+using DynModInt = DynamicModInt<0>;
+
+template <int Id>
+struct is_exact_ring<DynamicModInt<Id>> : std::true_type {};
+
+template <int Id>
+struct is_commutative<DynamicModInt<Id>> : std::true_type {};
+
+template <int Id>
+struct lazy_reduction<DynamicModInt<Id>> {
+    static constexpr bool kEnabled = true;
+
+    static uint32_t Raw(const DynamicModInt<Id>& value) {
+        return value.value_;
+    }
+
+    static uint32_t Modulus() {
+        return DynamicModInt<Id>::Modulus();
+    }
+
+    static size_t Terms() {
+        return DynamicModInt<Id>::terms_;
+    }
+
+    static uint64_t Fold(uint64_t sum) {
+        return DynamicModInt<Id>::barrett_.Reduce(sum);
+    }
+
+    static DynamicModInt<Id> FromSum(uint64_t sum) {
+        DynamicModInt<Id> res;
+        res.value_ = DynamicModInt<Id>::barrett_.Reduce(sum);
+        return res;
+    }
+};
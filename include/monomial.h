@@ -5,6 +5,7 @@
 #include <utility>
 
 #include "mp_fwd.h"  // Forward declaration
+#include "pow_functions.h"
 
 namespace SingleVariable {
 
@@ -25,7 +26,15 @@ public:
 
     template <typename U>
     SubstitutionType<U> operator()(const U& point) {
-        return coef_ * PowFunction()(point, degree_);
+        PowFunction pow;
+        return (*this)(point, pow);
+    }
+
+    // Raises point through the given policy object, so that state it keeps between
+    // calls, like the table of TablePow, is shared by every monomial evaluated with it
+    template <typename U>
+    SubstitutionType<U> operator()(const U& point, PowFunction& pow) {
+        return coef_ * pow(point, degree_);
     }
 
     const size_t& GetDegree() const {
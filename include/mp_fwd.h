@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstddef>
+#include <type_traits>
+#include <utility>
 
 #include "complex_type.h"
 
@@ -13,11 +15,44 @@ using SubType = decltype(std::declval<T>() - std::declval<U>());
 template <typename T, typename U>
 using MultiplyType = decltype(std::declval<T>() * std::declval<U>());
 
+// Division by small integers is exact, as in fields
+template <typename T>
+struct has_exact_division : std::is_floating_point<T> {};
+
+// Addition and multiplication are exact, so algorithms may trade multiplications for
+// additions and subtractions without losing accuracy
+template <typename T>
+struct is_exact_ring : std::is_integral<T> {};
+
+// a * b == b * a, so squares may compute every cross product once and double it
+template <typename T>
+struct is_commutative : std::is_arithmetic<T> {};
+
+// Signed integers multiplied as their unsigned type of the same width, whose wrapping
+// products have the same low bits. Types narrower than int stay signed: their unsigned
+// type promotes to int, where products can overflow, while their own products are
+// computed in int and converted back modulo 2^N.
+template <typename T>
+inline constexpr bool kMultipliedAsUnsigned =
+    std::is_integral_v<T> && std::is_signed_v<T> && sizeof(T) >= sizeof(int);
+
+template <typename T>
+class Matrix;
+
+template <typename T>
+struct is_matrix : std::false_type {};
+
+template <typename T>
+struct is_matrix<Matrix<T>> : std::true_type {};
+
 struct DefaultPow {
     template <typename T>
     T operator()(const T& object, size_t pow) {
-        T res(GetOne(object));
-        for (size_t i = 0; i < pow; ++i) {
+        if (pow == 0) {
+            return GetOne(object);
+        }
+        T res(object);
+        for (size_t i = 1; i < pow; ++i) {
             res *= object;
         }
         return res;
@@ -30,6 +65,9 @@ struct BinaryPow {
         if (pow == 0) {
             return GetOne(object);
         }
+        if (pow == 1) {
+            return object;
+        }
         if (pow % 2 == 1) {
             return object * (*this)(object, pow - 1);
         }
@@ -43,16 +81,25 @@ namespace SingleVariable {
 template <typename T, typename PowFunction = DefaultPow>
 class Monomial;
 
-template <typename T, typename PowFunction = DefaultPow>
+// Coefficient storage policies, see polynomial_storage.h
+struct SparseStorage;
+struct DenseStorage;
+
+template <typename T, typename PowFunction = DefaultPow, typename Storage = SparseStorage>
 class Polynomial;
 
 template <typename T>
 struct is_polynomial : std::false_type {};
 
-template <typename T, typename PowFunction>
-struct is_polynomial<Polynomial<T, PowFunction>> : std::true_type {};
+template <typename T, typename PowFunction, typename Storage>
+struct is_polynomial<Polynomial<T, PowFunction, Storage>> : std::true_type {};
+
+// Lazy combinations of polynomials, see polynomial_expression.h
+template <typename T>
+struct is_polynomial_expression : std::false_type {};
 
+// Neither a polynomial nor an expression of polynomials
 template <typename T>
-concept NotPolynomial = !is_polynomial<T>::value;
+concept NotPolynomial = !is_polynomial<T>::value && !is_polynomial_expression<T>::value;
 
 }  // namespace SingleVariable
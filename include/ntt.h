@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "modint.h"
+
+namespace SingleVariable {
+
+template <typename T>
+struct ntt_traits {
+    static constexpr bool kEnabled = false;
+};
+
+// Prime P = c * 2^k + 1 has roots of unity of every degree up to 2^k
+template <uint32_t P>
+struct ntt_traits<ModInt<P>> {
+    static constexpr size_t kMaxLog = std::countr_zero(P - 1);
+    static constexpr bool kEnabled = kMaxLog >= 8 && IsPrime(P);
+    static constexpr size_t kMaxSize = size_t{1} << kMaxLog;
+    static constexpr uint32_t kRoot = kEnabled ? PrimitiveRoot(P) : 0;
+};
+
+// roots[len + j] = w^j where w is a primitive root of unity of degree 2 * len. The table
+// for a transform of length n holds every smaller one, so it is grown once per thread.
+template <uint32_t P>
+const std::vector<ModInt<P>>& NttRoots(size_t size) {
+    thread_local std::vector<ModInt<P>> roots{ModInt<P>(0), ModInt<P>(1)};
+    for (size_t len = roots.size(); len < size; len *= 2) {
+        ModInt<P> root = ModInt<P>(ntt_traits<ModInt<P>>::kRoot).Pow((P - 1) / (2 * len));
+        roots.resize(2 * len);
+        for (size_t j = 0; j < len; j += 2) {
+            roots[len + j] = roots[len / 2 + j / 2];
+            roots[len + j + 1] = roots[len + j] * root;
+        }
+    }
+    return roots;
+}
+
+// In-place iterative transform, size must be a power of two
+template <uint32_t P>
+void Ntt(std::vector<ModInt<P>>& values) {
+    size_t size = values.size();
+    for (size_t i = 1, j = 0; i < size; ++i) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(values[i], values[j]);
+        }
+    }
+    const auto& roots = NttRoots<P>(size);
+    for (size_t len = 1; len < size; len *= 2) {
+        for (size_t start = 0; start < size; start += 2 * len) {
+            for (size_t j = 0; j < len; ++j) {
+                ModInt<P> u = values[start + j];
+                ModInt<P> v = values[start + j + len] * roots[len + j];
+                values[start + j] = u + v;
+                values[start + j + len] = u - v;
+            }
+        }
+    }
+}
+
+// The forward transform evaluates at w^k, reading its output backwards gives w^-k
+template <uint32_t P>
+void InverseNtt(std::vector<ModInt<P>>& values) {
+    Ntt(values);
+    std::reverse(values.begin() + 1, values.end());
+    ModInt<P> inv_size = ModInt<P>(static_cast<int64_t>(values.size())).Inverse();
+    for (auto& value : values) {
+        value *= inv_size;
+    }
+}
+
+// A square, lhs and rhs being the same vector, takes one forward transform
+template <uint32_t P>
+std::vector<ModInt<P>> NttConvolve(const std::vector<ModInt<P>>& lhs,
+                                   const std::vector<ModInt<P>>& rhs) {
+    size_t res_size = lhs.size() + rhs.size() - 1;
+    size_t size = std::bit_ceil(res_size);
+    std::vector<ModInt<P>> lhs_values(lhs);
+    lhs_values.resize(size);
+    Ntt(lhs_values);
+    if (&lhs == &rhs) {
+        for (auto& value : lhs_values) {
+            value *= value;
+        }
+    } else {
+        std::vector<ModInt<P>> rhs_values(rhs);
+        rhs_values.resize(size);
+        Ntt(rhs_values);
+        for (size_t i = 0; i < size; ++i) {
+            lhs_values[i] *= rhs_values[i];
+        }
+    }
+    InverseNtt(lhs_values);
+    lhs_values.resize(res_size);
+    return lhs_values;
+}
+
+}  // namespace SingleVariable
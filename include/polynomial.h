@@ -1,78 +1,169 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstddef>
 #include <initializer_list>
+#include <optional>
 #include <ostream>
 #include <regex>
 #include <set>
+#include <span>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "batch_evaluation.h"
 #include "complex_type.h"
 #include "monomial.h"
 #include "mp_fwd.h"  // Forward declaration
+#include "polynomial_expression.h"
+#include "polynomial_storage.h"
 
 namespace SingleVariable {
-template <typename T, typename PowFunction>
+template <typename T, typename PowFunction, typename Storage>
 class Polynomial {
 public:
-    template <typename U, typename OtherPow>
+    template <typename U, typename OtherPow, typename OtherStorage>
     friend class Polynomial;
 
     Polynomial() = default;
     explicit Polynomial(const T& other) {
-        monoms_.insert({0, Monomial<T>{other, 0}});
+        monoms_.Add(0, other);
     }
     Polynomial(const std::initializer_list<std::pair<T, size_t>>& list) {
+        std::vector<Monomial<T, PowFunction>> monoms;
+        monoms.reserve(list.size());
         for (const auto& [coef, degree] : list) {
-            AddMonom(coef, degree);
+            monoms.emplace_back(coef, degree);
         }
+        monoms_.Assign(std::move(monoms));
+    }
+
+    // Monomials may come in any order, equal degrees are summed
+    explicit Polynomial(std::vector<Monomial<T, PowFunction>> monoms) {
+        monoms_.Assign(std::move(monoms));
+    }
+
+    // Evaluates a lazy expression in one pass, see polynomial_expression.h
+    template <PolynomialExpression E>
+        requires std::is_same_v<ExpressionPolynomial<E>, Polynomial>
+    Polynomial(const E& expr) {
+        AssignExpression(expr);
+    }
+
+    template <PolynomialExpression E>
+        requires std::is_same_v<ExpressionPolynomial<E>, Polynomial>
+    Polynomial& operator=(const E& expr) {
+        AssignExpression(expr);
+        return *this;
+    }
+
+    template <PolynomialExpression E>
+        requires std::is_same_v<ExpressionPolynomial<E>, Polynomial>
+    Polynomial& operator+=(const E& expr) {
+        AssignExpression(Lazy(*this) + expr);
+        return *this;
+    }
+
+    template <PolynomialExpression E>
+        requires std::is_same_v<ExpressionPolynomial<E>, Polynomial>
+    Polynomial& operator-=(const E& expr) {
+        AssignExpression(Lazy(*this) - expr);
+        return *this;
+    }
+
+    // sum of scalars[i] * polys[i], computed in one pass like an expression
+    template <typename U>
+    static Polynomial LinearCombination(std::span<const U> scalars,
+                                        std::span<const Polynomial> polys) {
+        if (scalars.size() != polys.size()) {
+            throw std::runtime_error{"Scalars and polynomials have different sizes"};
+        }
+        Polynomial res;
+        res.monoms_.AssignSum([&scalars, &polys](const auto& visit) {
+            for (size_t i = 0; i < polys.size(); ++i) {
+                const U& multiplyer = scalars[i];
+                visit(polys[i].monoms_, [&multiplyer](const T& coef) { return multiplyer * coef; });
+            }
+        });
+        return res;
     }
 
     template <NotPolynomial U>
     Polynomial& operator+=(const U& other) {
-        AddMonom(other, 0);
+        monoms_.Add(0, other);
         return *this;
     }
 
     template <NotPolynomial U>
-    friend Polynomial<AddType<T, U>, PowFunction> operator+(const Polynomial<T, PowFunction>& lhs,
-                                                            const U& other) {
-        Polynomial<AddType<T, U>, PowFunction> tmp = lhs;
+    friend Polynomial<AddType<T, U>, PowFunction, Storage> operator+(
+        const Polynomial<T, PowFunction, Storage>& lhs, const U& other) {
+        auto tmp = lhs.template Convert<AddType<T, U>>();
         tmp += other;
         return tmp;
     }
 
+    // Operators taking a temporary polynomial with the coefficient type of the result
+    // work in its storage and move it out instead of copying. The check sits in the
+    // return type: as a requires-clause it recurses through AddType.
+    template <typename R>
+    using InPlaceResult = std::enable_if_t<std::is_same_v<R, T>, Polynomial>;
+
+    template <NotPolynomial U>
+    friend InPlaceResult<AddType<T, U>> operator+(Polynomial&& lhs, const U& other) {
+        lhs += other;
+        return std::move(lhs);
+    }
+
     template <NotPolynomial U>
-    friend Polynomial<AddType<U, T>, PowFunction> operator+(const U& other,
-                                                            const Polynomial<T, PowFunction>& rhs) {
-        Polynomial<AddType<U, T>, PowFunction> tmp = rhs;
-        tmp.AddMonom(other, 0);
+    friend Polynomial<AddType<U, T>, PowFunction, Storage> operator+(
+        const U& other, const Polynomial<T, PowFunction, Storage>& rhs) {
+        auto tmp = rhs.template Convert<AddType<U, T>>();
+        tmp += other;
         return tmp;
     }
 
+    template <NotPolynomial U>
+    friend InPlaceResult<AddType<U, T>> operator+(const U& other, Polynomial&& rhs) {
+        rhs += other;
+        return std::move(rhs);
+    }
+
     Polynomial& operator+=(const Monomial<T, PowFunction>& other) {
-        AddMonom(other);
+        monoms_.Add(other.GetDegree(), other.GetCoef());
         return *this;
     }
 
-    friend Polynomial<T, PowFunction> operator+(const Polynomial<T, PowFunction>& lhs,
-                                                const Monomial<T, PowFunction>& other) {
-        Polynomial<T, PowFunction> tmp = lhs;
+    friend Polynomial<T, PowFunction, Storage> operator+(
+        const Polynomial<T, PowFunction, Storage>& lhs, const Monomial<T, PowFunction>& other) {
+        Polynomial<T, PowFunction, Storage> tmp = lhs;
         tmp += other;
         return tmp;
     }
 
-    friend Polynomial<T, PowFunction> operator+(const Monomial<T, PowFunction>& other,
-                                                const Polynomial<T, PowFunction>& rhs) {
-        Polynomial<T, PowFunction> tmp = rhs;
-        tmp.AddMonom(other);
+    friend Polynomial operator+(Polynomial&& lhs, const Monomial<T, PowFunction>& other) {
+        lhs += other;
+        return std::move(lhs);
+    }
+
+    friend Polynomial<T, PowFunction, Storage> operator+(
+        const Monomial<T, PowFunction>& other, const Polynomial<T, PowFunction, Storage>& rhs) {
+        Polynomial<T, PowFunction, Storage> tmp = rhs;
+        tmp += other;
         return tmp;
     }
 
+    friend Polynomial operator+(const Monomial<T, PowFunction>& other, Polynomial&& rhs) {
+        rhs += other;
+        return std::move(rhs);
+    }
+
     template <NotPolynomial U>
     Polynomial& operator-=(const U& other) {
         *this += -other;
@@ -80,162 +171,469 @@ public:
     }
 
     template <NotPolynomial U>
-    friend Polynomial<AddType<T, U>, PowFunction> operator-(const Polynomial<T, PowFunction>& lhs,
-                                                            const U& other) {
-        Polynomial<AddType<T, U>, PowFunction> tmp = lhs;
+    friend Polynomial<AddType<T, U>, PowFunction, Storage> operator-(
+        const Polynomial<T, PowFunction, Storage>& lhs, const U& other) {
+        auto tmp = lhs.template Convert<AddType<T, U>>();
         tmp -= other;
         return tmp;
     }
 
+    template <NotPolynomial U>
+    friend InPlaceResult<AddType<T, U>> operator-(Polynomial&& lhs, const U& other) {
+        lhs -= other;
+        return std::move(lhs);
+    }
+
     template <typename U>
-    Polynomial& operator+=(const Polynomial<U, PowFunction>& other) {
-        for (auto [degree, monom] : other.monoms_) {
-            AddMonom(monom);
-        }
+    Polynomial& operator+=(const Polynomial<U, PowFunction, Storage>& other) {
+        monoms_.Merge(other.monoms_, [](const U& coef) -> const U& { return coef; });
         return *this;
     }
 
     template <typename U>
-    friend Polynomial<AddType<T, U>, PowFunction> operator+(const Polynomial<T, PowFunction>& lhs,
-                                                            const Polynomial<U, PowFunction>& rhs) {
-        Polynomial<AddType<T, U>, PowFunction> tmp = lhs;
+    friend Polynomial<AddType<T, U>, PowFunction, Storage> operator+(
+        const Polynomial<T, PowFunction, Storage>& lhs,
+        const Polynomial<U, PowFunction, Storage>& rhs) {
+        auto tmp = lhs.template Convert<AddType<T, U>>();
         tmp += rhs;
         return tmp;
     }
 
-    Polynomial operator-() {
+    friend Polynomial operator+(Polynomial&& lhs, const Polynomial& rhs) {
+        lhs += rhs;
+        return std::move(lhs);
+    }
+
+    friend Polynomial operator+(const Polynomial& lhs, Polynomial&& rhs) {
+        rhs += lhs;
+        return std::move(rhs);
+    }
+
+    friend Polynomial operator+(Polynomial&& lhs, Polynomial&& rhs) {
+        lhs += rhs;
+        return std::move(lhs);
+    }
+
+    Polynomial operator-() const& {
         auto tmp = *this;
-        for (auto& [degree, monom] : tmp.monoms_) {
-            monom.GetCoef() *= -1;
-        }
+        tmp.monoms_.Transform([](T& coef) { coef *= -1; });
         return tmp;
     }
 
+    Polynomial operator-() && {
+        monoms_.Transform([](T& coef) { coef *= -1; });
+        return std::move(*this);
+    }
+
     Polynomial& operator-=(const Polynomial& other) {
-        for (auto [degree, monom] : other.monoms_) {
-            AddMonom(-monom.GetCoef(), degree);
-        }
+        monoms_.Merge(other.monoms_, [](const T& coef) { return -coef; });
         return *this;
     }
 
-    Polynomial operator-(const Polynomial& other) {
+    Polynomial operator-(const Polynomial& other) const& {
         auto tmp = *this;
         tmp -= other;
         return tmp;
     }
 
+    Polynomial operator-(const Polynomial& other) && {
+        *this -= other;
+        return std::move(*this);
+    }
+
+    // lhs - rhs = -(rhs - lhs), computed in the storage of rhs
+    Polynomial operator-(Polynomial&& other) const& {
+        other -= *this;
+        return -std::move(other);
+    }
+
+    Polynomial operator-(Polynomial&& other) && {
+        *this -= other;
+        return std::move(*this);
+    }
+
     template <typename U>
-    friend Polynomial<MultiplyType<T, U>, PowFunction> operator*(
-        const Polynomial<T, PowFunction>& lhs, const Polynomial<U, PowFunction>& rhs) {
-        Polynomial<MultiplyType<T, U>, PowFunction> res;
-        for (const auto& [degree_1, monom_1] : lhs.monoms_) {
-            for (const auto& [degree_2, monom_2] : rhs.monoms_) {
-                res.AddMonom(monom_1.GetCoef() * monom_2.GetCoef(), degree_1 + degree_2);
-            }
-        }
+    friend Polynomial<MultiplyType<T, U>, PowFunction, Storage> operator*(
+        const Polynomial<T, PowFunction, Storage>& lhs,
+        const Polynomial<U, PowFunction, Storage>& rhs) {
+        return lhs.Multiply(rhs);
+    }
+
+    // Same as operator*, mode selects between fast and exact algorithms for
+    // floating-point coefficients
+    template <typename U>
+    Polynomial<MultiplyType<T, U>, PowFunction, Storage> Multiply(
+        const Polynomial<U, PowFunction, Storage>& rhs,
+        ConvolutionMode mode = ConvolutionMode::kFast) const {
+        Polynomial<MultiplyType<T, U>, PowFunction, Storage> res;
+        res.monoms_ = monoms_.Multiply(rhs.monoms_, mode);
         return res;
     }
 
+    // Same as Multiply(*this). Products are recognised as squares whenever both operands
+    // are one object, as in p * p or BinaryPow: NTT and FFT then transform once, and
+    // schoolbook and sparse products of commutative exact coefficients compute every
+    // cross product once.
+    Polynomial<MultiplyType<T, T>, PowFunction, Storage> Square(
+        ConvolutionMode mode = ConvolutionMode::kFast) const {
+        return Multiply(*this, mode);
+    }
+
     template <NotPolynomial U>
-    friend Polynomial<MultiplyType<U, T>, PowFunction> operator*(
-        const U& multiplyer, const Polynomial<T, PowFunction>& poly) {
-        Polynomial<MultiplyType<U, T>, PowFunction> tmp;
-        for (const auto& [degree, monom] : poly.monoms_) {
-            tmp.AddMonom(multiplyer * monom.GetCoef(), degree);
-        }
-        return tmp;
+    friend Polynomial<MultiplyType<U, T>, PowFunction, Storage> operator*(
+        const U& multiplyer, const Polynomial<T, PowFunction, Storage>& poly) {
+        return poly.template Map<MultiplyType<U, T>>(
+            [&multiplyer](const T& coef) { return multiplyer * coef; });
+    }
+
+    template <NotPolynomial U>
+    friend InPlaceResult<MultiplyType<U, T>> operator*(const U& multiplyer, Polynomial&& poly) {
+        poly.monoms_.Transform([&multiplyer](T& coef) { coef = multiplyer * coef; });
+        return std::move(poly);
     }
 
     template <typename U>
     Polynomial& operator*=(const U& multiplyer) {
-        for (auto& [degree, monom] : monoms_) {
-            monom.GetCoef() *= multiplyer;
-        }
+        monoms_.Transform([&multiplyer](T& coef) { coef *= multiplyer; });
         return *this;
     }
 
     template <NotPolynomial U>
-    friend Polynomial<MultiplyType<U, T>, PowFunction> operator*(
-        const Polynomial<T, PowFunction>& poly, const U& multiplyer) {
-        Polynomial<MultiplyType<T, U>, PowFunction> tmp;
-        for (const auto& [degree, monom] : poly.monoms_) {
-            tmp.AddMonom(monom.GetCoef() * multiplyer, degree);
-        }
-        return tmp;
+    friend Polynomial<MultiplyType<T, U>, PowFunction, Storage> operator*(
+        const Polynomial<T, PowFunction, Storage>& poly, const U& multiplyer) {
+        return poly.template Map<MultiplyType<T, U>>(
+            [&multiplyer](const T& coef) { return coef * multiplyer; });
+    }
+
+    template <NotPolynomial U>
+    friend InPlaceResult<MultiplyType<T, U>> operator*(Polynomial&& poly, const U& multiplyer) {
+        poly *= multiplyer;
+        return std::move(poly);
     }
 
     Polynomial& operator*=(const Polynomial& other) {
-        Polynomial<T, PowFunction> buff;
-        for (const auto& [degree_1, monom_1] : monoms_) {
-            for (const auto& [degree_2, monom_2] : other.monoms_) {
-                buff.AddMonom(monom_1.GetCoef() * monom_2.GetCoef(), degree_1 + degree_2);
-            }
-        }
-        *this = buff;
+        *this = Multiply(other);
         return *this;
     }
 
+    // Evaluation does not go through PowFunction, which only raises the point for a
+    // single Monomial: all terms share one chain of powers instead, see EvaluateHorner
+    // and EvaluatePatersonStockmeyer
     template <typename U>
-    auto operator()(const U& point) {
-        auto res = GetZero(point);
-        for (auto [degree, monom] : monoms_) {
-            res += monom(point);
+    auto operator()(const U& point) const {
+        if (auto res = EvaluateTermwise(point)) {
+            return *res;
+        }
+        if constexpr (is_matrix<U>::value) {
+            if (auto res = EvaluatePatersonStockmeyer(point)) {
+                return *res;
+            }
+        }
+        auto horner = EvaluateHorner(point);
+        if (!horner) {
+            return GetZero(point);
+        }
+        if constexpr (is_matrix<U>::value &&
+                      std::is_same_v<typename decltype(horner)::value_type, U>) {
+            return std::move(*horner);
+        } else {
+            U res = GetZero(point);
+            res += *horner;
+            return res;
         }
-        return res;
     }
 
-    void Reduce() {
-        std::vector<typename std::unordered_map<size_t, Monomial<T, PowFunction>>::iterator>
-            zero_vals;
-        for (auto it = monoms_.begin(); it != monoms_.end(); ++it) {
-            if (it->second.GetCoef() == GetZero(it->second.GetCoef())) {
-                zero_vals.push_back(it);
-            }
+    // out[i] = (*this)(points[i]). Arithmetic points of the kBatchEvaluated types with
+    // arithmetic coefficients run a vectorized Horner kernel across points, see
+    // batch_evaluation.h; everything else is evaluated point by point.
+    template <typename U, typename R>
+    void Evaluate(std::span<const U> points, std::span<R> out) const {
+        if (points.size() != out.size()) {
+            throw std::runtime_error{"Points and results have different sizes"};
         }
-        for (const auto& it : zero_vals) {
-            monoms_.erase(it);
+        if constexpr (kBatchEvaluated<U> && std::is_arithmetic_v<T> &&
+                      (std::is_floating_point_v<U> || std::is_integral_v<T>)) {
+            using W = BatchWorkType<U>;
+            HornerProgram<W> program;
+            size_t prev_degree = 0;
+            monoms_.ForEachReversed([&program, &prev_degree](size_t degree, const T& coef) {
+                if (!program.coefs.empty()) {
+                    program.gaps.push_back(prev_degree - degree);
+                }
+                program.coefs.push_back(static_cast<W>(coef));
+                prev_degree = degree;
+            });
+            program.gaps.push_back(prev_degree);
+            const W* work_points = reinterpret_cast<const W*>(points.data());
+            if constexpr (std::is_same_v<R, U>) {
+                EvaluateBatch(program, work_points, reinterpret_cast<W*>(out.data()), out.size());
+            } else {
+                std::vector<W> buffer(out.size());
+                EvaluateBatch(program, work_points, buffer.data(), buffer.size());
+                for (size_t i = 0; i < out.size(); ++i) {
+                    out[i] = static_cast<R>(static_cast<U>(buffer[i]));
+                }
+            }
+        } else {
+            for (size_t i = 0; i < points.size(); ++i) {
+                out[i] = (*this)(points[i]);
+            }
         }
     }
 
+    void Reduce() {
+        monoms_.RemoveZeros();
+    }
+
+    // Terms come in ascending degree order, which is the reverse of the set order,
+    // so every insertion is a constant time hinted insert at the front
     std::set<Monomial<T, PowFunction>> GetMonomials() const {
         std::set<Monomial<T, PowFunction>> res_lst;
-        for (const auto& [degree, monom] : monoms_) {
-            res_lst.insert(monom);
-        }
+        monoms_.ForEach([&res_lst](size_t degree, const T& coef) {
+            res_lst.emplace_hint(res_lst.begin(), coef, degree);
+        });
         return res_lst;
     }
 
-    friend bool operator==(const Polynomial<T, PowFunction>& lhs,
-                           const Polynomial<T, PowFunction>& rhs) {
+    friend bool operator==(const Polynomial<T, PowFunction, Storage>& lhs,
+                           const Polynomial<T, PowFunction, Storage>& rhs) {
         return lhs.monoms_ == rhs.monoms_;
     }
 
+    template <typename U, typename OtherPow, typename OtherStorage>
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const Polynomial<U, OtherPow, OtherStorage>& poly);
+
 private:
+    using Container = typename Storage::template Container<T, PowFunction>;
+
+    // Horner's rule from the highest degree down: acc = acc * point^gap + coef, where gap
+    // is the distance to the previous term. Coefficients stay on the left of every
+    // product. Returns nothing for a polynomial without terms.
+    //
+    // Gaps are bridged by binary exponentiation over one table of repeated squares of
+    // point shared by all terms, so t terms up to degree n cost at most log(n) squarings
+    // plus one multiplication per set bit of every gap. PowFunction is not used: any
+    // policy raising the point once per gap would repeat those squarings.
+    // Coefficients enter as coef * GetLazyOne(point), so scalar coefficients at a matrix
+    // are added on the diagonal and matrix coefficients are scaled, not multiplied.
+    template <typename U>
+    auto EvaluateHorner(const U& point) const {
+        const auto one = GetLazyOne(point);
+        std::optional<MultiplyType<const T&, const U&>> acc;
+        size_t prev_degree = 0;
+        std::vector<U> squares{point};
+        auto advance = [&acc, &squares](size_t gap) {
+            for (size_t bit = 0; (gap >> bit) != 0; ++bit) {
+                if (bit == squares.size()) {
+                    squares.push_back(squares.back() * squares.back());
+                }
+                if ((gap >> bit) & 1) {
+                    *acc *= squares[bit];
+                }
+            }
+        };
+        monoms_.ForEachReversed([&](size_t degree, const T& coef) {
+            if (acc) {
+                advance(prev_degree - degree);
+                *acc += coef * one;
+            } else {
+                acc.emplace(coef * one);
+            }
+            prev_degree = degree;
+        });
+        if (acc) {
+            advance(prev_degree);
+        }
+        return acc;
+    }
+
+    // Multiplications the Horner chain of EvaluateHorner needs
+    size_t HornerCost() const {
+        size_t cost = 0;
+        size_t max_gap = 0;
+        size_t prev_degree = 0;
+        bool first = true;
+        monoms_.ForEachReversed([&](size_t degree, const T&) {
+            if (!first) {
+                cost += std::popcount(prev_degree - degree);
+                max_gap = std::max(max_gap, prev_degree - degree);
+            }
+            prev_degree = degree;
+            first = false;
+        });
+        cost += std::popcount(prev_degree);
+        max_gap = std::max(max_gap, prev_degree);
+        return cost + (max_gap == 0 ? 0 : std::bit_width(max_gap) - 1);
+    }
+
+    // sum of coef * point^degree term by term, for coefficients whose products with the
+    // point are narrowed back to its type, like double coefficients at an int or at an
+    // int matrix. Horner's rule would narrow the running sum once at the end; here every
+    // term is narrowed on its own, as Monomial does, and a matrix narrows every element
+    // of coef * point^degree. So p(x) is the diagonal of p(x * I). Powers come from one
+    // table of repeated squares. Returns nothing for other coefficients.
+    template <typename U>
+    std::optional<U> EvaluateTermwise(const U& point) const {
+        using Product = MultiplyType<const T&, const U&>;
+        if constexpr (std::is_same_v<Product, U> || !std::is_convertible_v<Product, U>) {
+            return std::nullopt;
+        } else {
+            U res = GetZero(point);
+            std::vector<U> squares{point};
+            monoms_.ForEach([&](size_t degree, const T& coef) {
+                if (degree == 0) {
+                    res += static_cast<U>(coef * GetLazyOne(point));
+                } else {
+                    res += static_cast<U>(coef * PowerOfSquares(squares, degree));
+                }
+            });
+            return res;
+        }
+    }
+
+    template <typename V>
+    std::optional<Matrix<V>> EvaluateTermwise(const Matrix<V>& point) const {
+        using Product = MultiplyType<const T&, const V&>;
+        if constexpr (std::is_same_v<Product, V> || !std::is_convertible_v<Product, V>) {
+            return std::nullopt;
+        } else {
+            Matrix<V> res(point.Rows(), point.Columns());
+            std::vector<Matrix<V>> squares{point};
+            monoms_.ForEach([&](size_t degree, const T& coef) {
+                if (degree == 0) {
+                    res += coef * GetLazyOne(point);
+                } else {
+                    res += coef * PowerOfSquares(squares, degree);
+                }
+            });
+            return res;
+        }
+    }
+
+    // point^degree for degree > 0 from squares = {point, point^2, point^4, ...}, which is
+    // extended as needed
     template <typename U>
-    void AddMonom(const U& coef, size_t degree) {
-        if (monoms_.contains(degree)) {
-            monoms_[degree].GetCoef() += coef;
+    static U PowerOfSquares(std::vector<U>& squares, size_t degree) {
+        size_t bit = std::countr_zero(degree);
+        for (size_t i = squares.size(); i < std::bit_width(degree); ++i) {
+            squares.push_back(squares.back() * squares.back());
+        }
+        U power = squares[bit];
+        for (++bit; (degree >> bit) != 0; ++bit) {
+            if ((degree >> bit) & 1) {
+                power *= squares[bit];
+            }
+        }
+        return power;
+    }
+
+    // Paterson-Stockmeyer for scalar coefficients at a matrix: with k ~ sqrt(n) and
+    // B_j(X) = sum_{i < k} c_{jk+i} X^i, p(X) = sum_j B_j(X) (X^k)^j is computed by
+    // Horner's rule in X^k. Only X^2..X^k and one product per block are matrix
+    // products, about 2 sqrt(n) in total; the B_j are added element by element.
+    // Returns nothing when the sparse Horner chain is cheaper, and for coefficients of
+    // another type than the elements, which would have to be converted before the
+    // products instead of after them.
+    template <typename V>
+    std::optional<Matrix<V>> EvaluatePatersonStockmeyer(const Matrix<V>& point) const {
+        if constexpr (!std::is_same_v<T, V>) {
+            return std::nullopt;
         } else {
-            monoms_[degree] = {coef, degree};
+            std::vector<std::pair<size_t, V>> terms;
+            monoms_.ForEach(
+                [&terms](size_t degree, const T& coef) { terms.emplace_back(degree, coef); });
+            if (terms.empty() || point.Rows() != point.Columns()) {
+                return std::nullopt;
+            }
+            size_t degree = terms.back().first;
+            size_t step = std::max<size_t>(1, std::sqrt(static_cast<double>(degree + 1)));
+            if (step - 1 + degree / step >= HornerCost()) {
+                return std::nullopt;
+            }
+
+            size_t dim = point.Rows();
+            std::vector<Matrix<V>> powers;
+            powers.reserve(step + 1);
+            powers.emplace_back(size_t{0});  // X^0 is added on the diagonal directly
+            powers.push_back(point);
+            for (size_t i = 2; i <= step; ++i) {
+                powers.emplace_back(dim);
+                MultiplyInto(powers[i - 1], point, powers[i]);
+            }
+
+            Matrix<V> res(dim);
+            Matrix<V> scratch(dim);
+            auto add_block = [&](size_t block, auto begin, auto end) {
+                for (auto it = begin; it != end; ++it) {
+                    const auto& [term_degree, coef] = *it;
+                    size_t power = term_degree - block * step;
+                    if (power == 0) {
+                        for (size_t row = 0; row < dim; ++row) {
+                            res(row, row) += coef;
+                        }
+                        continue;
+                    }
+                    for (size_t row = 0; row < dim; ++row) {
+                        for (size_t col = 0; col < dim; ++col) {
+                            res(row, col) += coef * powers[power](row, col);
+                        }
+                    }
+                }
+            };
+            auto end = terms.end();
+            for (size_t block = degree / step + 1; block-- > 0;) {
+                if (block != degree / step) {
+                    MultiplyInto(res, powers[step], scratch);
+                    std::swap(res, scratch);
+                }
+                auto begin = std::lower_bound(
+                    terms.begin(), end, block * step,
+                    [](const auto& term, size_t value) { return term.first < value; });
+                add_block(block, begin, end);
+                end = begin;
+            }
+            return res;
         }
     }
 
-    void AddMonom(const Monomial<T, PowFunction>& monom) {
-        if (monoms_.contains(monom.GetDegree())) {
-            monoms_[monom.GetDegree()].GetCoef() += monom.GetCoef();
+    template <typename E>
+    void AssignExpression(const E& expr) {
+        monoms_.AssignSum([&expr](const auto& visit) {
+            expr.ForEachLeaf(
+                [&visit](const Polynomial& poly, const auto& f) { visit(poly.monoms_, f); });
+        });
+    }
+
+    template <typename R, typename F>
+    Polynomial<R, PowFunction, Storage> Map(F&& f) const {
+        Polynomial<R, PowFunction, Storage> res;
+        res.monoms_ = monoms_.template Map<R>(std::forward<F>(f));
+        return res;
+    }
+
+    template <typename R>
+    Polynomial<R, PowFunction, Storage> Convert() const {
+        if constexpr (std::is_same_v<R, T>) {
+            return *this;
         } else {
-            monoms_[monom.GetDegree()] = monom;
+            return Map<R>([](const T& coef) { return R(coef); });
         }
     }
-    std::unordered_map<size_t, Monomial<T, PowFunction>> monoms_;
+
+    Container monoms_;
 };
 
-template <typename T, typename U>
-std::ostream& operator<<(std::ostream& os, const Polynomial<T, U>& poly) {
-    auto sorted = poly.GetMonomials();
+template <typename T, typename PowFunction, typename Storage>
+std::ostream& operator<<(std::ostream& os, const Polynomial<T, PowFunction, Storage>& poly) {
     size_t ind = 0;
-    for (auto monom : sorted) {
-        int sign = monom.GetCoef() < 0 ? -1 : 1;
+    poly.monoms_.ForEachReversed([&os, &ind](size_t degree, const T& coef) {
+        Monomial<T, PowFunction> monom(coef, degree);
+        int sign = 1;
+        // Coefficients without an order, like residues, are printed as is
+        if constexpr (requires { coef < 0; }) {
+            sign = monom.GetCoef() < 0 ? -1 : 1;
+        }
         if (sign < 0) {
             os << '-';
             monom.GetCoef() *= -1;
@@ -251,33 +649,33 @@ std::ostream& operator<<(std::ostream& os, const Polynomial<T, U>& poly) {
         }
         os << ' ';
         ++ind;
-    }
+    });
     return os;
 }
 
-template <typename T, typename PowFunction = DefaultPow>
-Polynomial<T, PowFunction> GetZeroPolynomial() {
-    return Polynomial<T, PowFunction>{T(0)};
+template <typename T, typename PowFunction = DefaultPow, typename Storage = SparseStorage>
+Polynomial<T, PowFunction, Storage> GetZeroPolynomial() {
+    return Polynomial<T, PowFunction, Storage>{T(0)};
 }
 
-template <typename T, typename PowFunction = DefaultPow>
-Polynomial<T, PowFunction> GetZeroPolynomialSafe(const T& example) {
-    return Polynomial<T, PowFunction>{GetZero(example)};
+template <typename T, typename PowFunction = DefaultPow, typename Storage = SparseStorage>
+Polynomial<T, PowFunction, Storage> GetZeroPolynomialSafe(const T& example) {
+    return Polynomial<T, PowFunction, Storage>{GetZero(example)};
 }
 
-template <typename T, typename PowFunction = DefaultPow>
-Polynomial<T, PowFunction> GetOnePolynomial() {
-    return Polynomial<T, PowFunction>{T(1)};
+template <typename T, typename PowFunction = DefaultPow, typename Storage = SparseStorage>
+Polynomial<T, PowFunction, Storage> GetOnePolynomial() {
+    return Polynomial<T, PowFunction, Storage>{T(1)};
 }
 
-template <typename T, typename PowFunction = DefaultPow>
-Polynomial<T, PowFunction> GetOnePolynomialSafe(const T& example) {
-    return Polynomial<T, PowFunction>{GetOne(example)};
+template <typename T, typename PowFunction = DefaultPow, typename Storage = SparseStorage>
+Polynomial<T, PowFunction, Storage> GetOnePolynomialSafe(const T& example) {
+    return Polynomial<T, PowFunction, Storage>{GetOne(example)};
 }
 
-template <typename T, typename PowFunction = DefaultPow>
-Polynomial<T, PowFunction> ParseFromString(std::string_view str) {
-    Polynomial<T, PowFunction> result;
+template <typename T, typename PowFunction = DefaultPow, typename Storage = SparseStorage>
+Polynomial<T, PowFunction, Storage> ParseFromString(std::string_view str) {
+    std::vector<Monomial<T, PowFunction>> monoms;
 
     std::string s;
     for (char c : str) {
@@ -324,10 +722,10 @@ Polynomial<T, PowFunction> ParseFromString(std::string_view str) {
             }
         }
 
-        result += Monomial<T, PowFunction>(coef, degree);
+        monoms.emplace_back(coef, degree);
     }
 
-    return result;
+    return Polynomial<T, PowFunction, Storage>(std::move(monoms));
 }
 
 }  // namespace SingleVariable
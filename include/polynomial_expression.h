@@ -0,0 +1,257 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+#include "mp_fwd.h"  // Forward declaration
+
+namespace SingleVariable {
+
+// Lazy linear combinations of polynomials. Operators on an expression build a small tree
+// instead of polynomials; converting or assigning it to a Polynomial evaluates the
+// whole tree in one pass into the destination, see AssignSum in polynomial_storage.h.
+// Expressions are opt-in: start one with Lazy(p), then
+//
+//   Polynomial<int> r = Lazy(p1) + p2 - 3 * Lazy(p3) + p4;
+//
+// builds no intermediate polynomial. Every node supports ForEachLeaf(f), which calls
+// f(poly, g) for every polynomial of the tree, where g maps a coefficient of poly to
+// its contribution to the result.
+//
+// Polynomial operands are referenced, temporaries are moved into the expression. An
+// expression kept in a variable must not outlive the polynomials it refers to.
+
+template <typename T>
+struct expression_traits;
+
+template <typename T, typename PowFunction, typename Storage>
+struct expression_traits<Polynomial<T, PowFunction, Storage>> {
+    using PolynomialType = Polynomial<T, PowFunction, Storage>;
+    using Coefficient = T;
+};
+
+// Polynomial taken by reference
+template <typename P>
+class PolynomialRef {
+public:
+    using PolynomialType = P;
+
+    explicit PolynomialRef(const P& poly) : poly_(&poly) {
+    }
+
+    template <typename F>
+    void ForEachLeaf(F&& f) const {
+        f(*poly_, [](const auto& coef) -> const auto& { return coef; });
+    }
+
+private:
+    const P* poly_;
+};
+
+// Temporary polynomial owned by the expression
+template <typename P>
+class PolynomialValue {
+public:
+    using PolynomialType = P;
+
+    explicit PolynomialValue(P&& poly) : poly_(std::move(poly)) {
+    }
+
+    template <typename F>
+    void ForEachLeaf(F&& f) const {
+        f(poly_, [](const auto& coef) -> const auto& { return coef; });
+    }
+
+private:
+    P poly_;
+};
+
+template <typename L, typename R>
+class PolynomialSum {
+public:
+    using PolynomialType = typename L::PolynomialType;
+
+    PolynomialSum(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+    }
+
+    template <typename F>
+    void ForEachLeaf(F&& f) const {
+        lhs_.ForEachLeaf(f);
+        rhs_.ForEachLeaf(f);
+    }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+template <typename L, typename R>
+class PolynomialDifference {
+public:
+    using PolynomialType = typename L::PolynomialType;
+
+    PolynomialDifference(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+    }
+
+    template <typename F>
+    void ForEachLeaf(F&& f) const {
+        lhs_.ForEachLeaf(f);
+        rhs_.ForEachLeaf([&f](const PolynomialType& poly, const auto& g) {
+            f(poly, [&g](const auto& coef) { return -g(coef); });
+        });
+    }
+
+private:
+    L lhs_;
+    R rhs_;
+};
+
+template <typename E>
+class PolynomialNegation {
+public:
+    using PolynomialType = typename E::PolynomialType;
+
+    explicit PolynomialNegation(E expr) : expr_(std::move(expr)) {
+    }
+
+    template <typename F>
+    void ForEachLeaf(F&& f) const {
+        expr_.ForEachLeaf([&f](const PolynomialType& poly, const auto& g) {
+            f(poly, [&g](const auto& coef) { return -g(coef); });
+        });
+    }
+
+private:
+    E expr_;
+};
+
+// Multiplication by a scalar, which stays on the side it was written on since
+// coefficients need not commute with it
+template <typename E, typename U, bool kScalarFirst>
+class PolynomialScaled {
+public:
+    using PolynomialType = typename E::PolynomialType;
+
+    PolynomialScaled(E expr, U multiplyer)
+        : expr_(std::move(expr)), multiplyer_(std::move(multiplyer)) {
+    }
+
+    template <typename F>
+    void ForEachLeaf(F&& f) const {
+        expr_.ForEachLeaf([this, &f](const PolynomialType& poly, const auto& g) {
+            f(poly, [this, &g](const auto& coef) {
+                if constexpr (kScalarFirst) {
+                    return multiplyer_ * g(coef);
+                } else {
+                    return g(coef) * multiplyer_;
+                }
+            });
+        });
+    }
+
+private:
+    E expr_;
+    U multiplyer_;
+};
+
+template <typename P>
+struct is_polynomial_expression<PolynomialRef<P>> : std::true_type {};
+
+template <typename P>
+struct is_polynomial_expression<PolynomialValue<P>> : std::true_type {};
+
+template <typename L, typename R>
+struct is_polynomial_expression<PolynomialSum<L, R>> : std::true_type {};
+
+template <typename L, typename R>
+struct is_polynomial_expression<PolynomialDifference<L, R>> : std::true_type {};
+
+template <typename E>
+struct is_polynomial_expression<PolynomialNegation<E>> : std::true_type {};
+
+template <typename E, typename U, bool kScalarFirst>
+struct is_polynomial_expression<PolynomialScaled<E, U, kScalarFirst>> : std::true_type {};
+
+template <typename T>
+concept PolynomialExpression = is_polynomial_expression<std::remove_cvref_t<T>>::value;
+
+template <typename T>
+    requires PolynomialExpression<T>
+struct expression_traits<T> : expression_traits<typename T::PolynomialType> {};
+
+template <typename T>
+using ExpressionPolynomial = typename expression_traits<std::remove_cvref_t<T>>::PolynomialType;
+
+template <typename T>
+using ExpressionCoefficient = typename expression_traits<std::remove_cvref_t<T>>::Coefficient;
+
+// Operands of an expression operator: at least one expression, the other one may be a
+// polynomial, and both over the same polynomial type
+template <typename L, typename R>
+concept ExpressionOperands =
+    (PolynomialExpression<L> || PolynomialExpression<R>) &&
+    (PolynomialExpression<L> || is_polynomial<std::remove_cvref_t<L>>::value) &&
+    (PolynomialExpression<R> || is_polynomial<std::remove_cvref_t<R>>::value) &&
+    std::is_same_v<ExpressionPolynomial<L>, ExpressionPolynomial<R>>;
+
+// Scalars whose product with the coefficients keeps their type, kScalarFirst tells on
+// which side the scalar is
+template <typename U, typename E, bool kScalarFirst>
+concept ExpressionScalar =
+    NotPolynomial<U> &&
+    ((kScalarFirst && std::is_same_v<MultiplyType<const U&, const ExpressionCoefficient<E>&>,
+                                     ExpressionCoefficient<E>>) ||
+     (!kScalarFirst && std::is_same_v<MultiplyType<const ExpressionCoefficient<E>&, const U&>,
+                                      ExpressionCoefficient<E>>));
+
+template <typename T, typename PowFunction, typename Storage>
+PolynomialRef<Polynomial<T, PowFunction, Storage>> Lazy(
+    const Polynomial<T, PowFunction, Storage>& poly) {
+    return PolynomialRef<Polynomial<T, PowFunction, Storage>>(poly);
+}
+
+template <typename T>
+auto AsExpression(T&& operand) {
+    using D = std::remove_cvref_t<T>;
+    if constexpr (PolynomialExpression<D>) {
+        return D(std::forward<T>(operand));
+    } else if constexpr (std::is_rvalue_reference_v<T&&>) {
+        return PolynomialValue<D>(std::move(operand));
+    } else {
+        return PolynomialRef<D>(operand);
+    }
+}
+
+template <typename L, typename R>
+    requires ExpressionOperands<L, R>
+auto operator+(L&& lhs, R&& rhs) {
+    return PolynomialSum(AsExpression(std::forward<L>(lhs)), AsExpression(std::forward<R>(rhs)));
+}
+
+template <typename L, typename R>
+    requires ExpressionOperands<L, R>
+auto operator-(L&& lhs, R&& rhs) {
+    return PolynomialDifference(AsExpression(std::forward<L>(lhs)),
+                                AsExpression(std::forward<R>(rhs)));
+}
+
+template <PolynomialExpression E>
+auto operator-(E&& expr) {
+    return PolynomialNegation(AsExpression(std::forward<E>(expr)));
+}
+
+template <typename U, PolynomialExpression E>
+    requires ExpressionScalar<U, E, true>
+auto operator*(const U& multiplyer, E&& expr) {
+    return PolynomialScaled<std::remove_cvref_t<E>, U, true>(AsExpression(std::forward<E>(expr)),
+                                                              multiplyer);
+}
+
+template <PolynomialExpression E, typename U>
+    requires ExpressionScalar<U, E, false>
+auto operator*(E&& expr, const U& multiplyer) {
+    return PolynomialScaled<std::remove_cvref_t<E>, U, false>(AsExpression(std::forward<E>(expr)),
+                                                               multiplyer);
+}
+
+}  // namespace SingleVariable
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "complex_type.h"
+#include "convolution.h"
+#include "monomial.h"
+#include "mp_fwd.h"  // Forward declaration
+
+namespace SingleVariable {
+
+// Both containers expose the same interface to Polynomial:
+//   Assign(monoms)     - replaces the contents with unsorted monomials, combining equal degrees
+//   Add(degree, coef)  - adds coef to the term of the given degree, creating it if absent
+//   Merge(other, f)    - adds f(coef) for every term of other
+//   AssignSum(terms)   - replaces the contents with a sum over several containers:
+//                        terms(visit) calls visit(container, f) for each of them, and
+//                        every term of the container contributes f(coef). terms is
+//                        called twice and must visit the same containers both times.
+//   ForEach(f)         - calls f(degree, coef) for every term in ascending degree order
+//   ForEachReversed(f) - the same in descending degree order
+//   Transform(f)       - calls f(coef) for every stored coefficient
+//   Map<R>(f)          - container of the same shape with coefficients f(coef)
+//   Multiply(rhs, m)   - product of two containers, m is passed on to Convolve
+//   RemoveZeros()      - drops terms with zero coefficient
+
+// Up to this many containers are united by scanning all of them for the next degree
+inline constexpr size_t kLinearUnionSources = 8;
+
+// Monomials sorted by ascending degree in one contiguous array. Terms are kept even if
+// their coefficient is zero, so a polynomial remembers every degree it was ever given.
+template <typename T, typename PowFunction>
+class SparseCoefficients {
+public:
+    template <typename U, typename OtherPow>
+    friend class SparseCoefficients;
+
+    void Assign(std::vector<Monomial<T, PowFunction>> monoms) {
+        std::stable_sort(monoms.begin(), monoms.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.GetDegree() < rhs.GetDegree();
+        });
+        monoms_.clear();
+        monoms_.reserve(monoms.size());
+        for (auto& monom : monoms) {
+            if (!monoms_.empty() && monoms_.back().GetDegree() == monom.GetDegree()) {
+                monoms_.back().GetCoef() += monom.GetCoef();
+            } else {
+                monoms_.push_back(std::move(monom));
+            }
+        }
+    }
+
+    template <typename U>
+    void Add(size_t degree, const U& coef) {
+        if (monoms_.empty() || monoms_.back().GetDegree() < degree) {
+            monoms_.emplace_back(coef, degree);
+            return;
+        }
+        auto it = LowerBound(degree);
+        if (it->GetDegree() == degree) {
+            it->GetCoef() += coef;
+        } else {
+            monoms_.insert(it, Monomial<T, PowFunction>(coef, degree));
+        }
+    }
+
+    // Terms of *this are moved into the result as they are merged, so p += p merges a copy
+    template <typename U, typename F>
+    void Merge(const SparseCoefficients<U, PowFunction>& other, F&& f) {
+        if (other.monoms_.empty()) {
+            return;
+        }
+        if (static_cast<const void*>(&other) == this) {
+            SparseCoefficients copy = *this;
+            Merge(copy, std::forward<F>(f));
+            return;
+        }
+        std::vector<Monomial<T, PowFunction>> merged;
+        merged.reserve(monoms_.size() + other.monoms_.size());
+        auto lhs = monoms_.begin();
+        auto rhs = other.monoms_.begin();
+        while (lhs != monoms_.end() || rhs != other.monoms_.end()) {
+            if (rhs == other.monoms_.end() ||
+                (lhs != monoms_.end() && lhs->GetDegree() < rhs->GetDegree())) {
+                merged.push_back(std::move(*lhs++));
+            } else if (lhs == monoms_.end() || rhs->GetDegree() < lhs->GetDegree()) {
+                merged.emplace_back(f(rhs->GetCoef()), rhs->GetDegree());
+                ++rhs;
+            } else {
+                merged.push_back(std::move(*lhs++));
+                merged.back().GetCoef() += f(rhs->GetCoef());
+                ++rhs;
+            }
+        }
+        monoms_ = std::move(merged);
+    }
+
+    // The first pass lays out the union of the degrees of all containers with zero
+    // coefficients, the second adds every coefficient at its degree. Sources may
+    // include *this.
+    template <typename Terms>
+    void AssignSum(const Terms& terms) {
+        std::vector<const SparseCoefficients*> sources;
+        size_t longest = 0;
+        terms([&sources, &longest](const SparseCoefficients& source, const auto&) {
+            if (!source.monoms_.empty()) {
+                sources.push_back(&source);
+                longest = std::max(longest, source.monoms_.size());
+            }
+        });
+        std::vector<Monomial<T, PowFunction>> sum;
+        sum.reserve(longest);
+        if (!sources.empty()) {
+            const T zero = GetZero(sources.front()->monoms_.front().GetCoef());
+            UniteDegrees(sources, [&sum, &zero](size_t degree) { sum.emplace_back(zero, degree); });
+        }
+        terms([&sum](const SparseCoefficients& source, const auto& f) {
+            auto it = sum.begin();
+            for (const auto& monom : source.monoms_) {
+                it = Gallop(it, sum.end(), monom.GetDegree());
+                it->GetCoef() += f(monom.GetCoef());
+            }
+        });
+        monoms_ = std::move(sum);
+    }
+
+    template <typename F>
+    void ForEach(F&& f) const {
+        for (const auto& monom : monoms_) {
+            f(monom.GetDegree(), monom.GetCoef());
+        }
+    }
+
+    template <typename F>
+    void ForEachReversed(F&& f) const {
+        for (auto it = monoms_.rbegin(); it != monoms_.rend(); ++it) {
+            f(it->GetDegree(), it->GetCoef());
+        }
+    }
+
+    template <typename F>
+    void Transform(F&& f) {
+        for (auto& monom : monoms_) {
+            f(monom.GetCoef());
+        }
+    }
+
+    template <typename R, typename F>
+    SparseCoefficients<R, PowFunction> Map(F&& f) const {
+        SparseCoefficients<R, PowFunction> res;
+        res.monoms_.reserve(monoms_.size());
+        for (const auto& monom : monoms_) {
+            res.monoms_.emplace_back(f(monom.GetCoef()), monom.GetDegree());
+        }
+        return res;
+    }
+
+    // Operands without gaps in their degrees go through Convolve, the product of such
+    // polynomials has no gaps either. Otherwise accumulates into a degree-indexed buffer
+    // when the product is dense enough, or sorts all pairwise products and combines
+    // equal degrees.
+    template <typename U>
+    SparseCoefficients<MultiplyType<T, U>, PowFunction> Multiply(
+        const SparseCoefficients<U, PowFunction>& rhs, ConvolutionMode mode) const {
+        using R = MultiplyType<T, U>;
+        SparseCoefficients<R, PowFunction> res;
+        if (monoms_.empty() || rhs.monoms_.empty()) {
+            return res;
+        }
+        size_t low = monoms_.front().GetDegree() + rhs.monoms_.front().GetDegree();
+        if (std::min(Size(), rhs.Size()) >= kKaratsubaThreshold && IsContiguous() &&
+            rhs.IsContiguous()) {
+            auto coefs = [&] {
+                auto lhs_coefs = Coefficients();
+                if constexpr (std::is_same_v<T, U>) {
+                    if (this == &rhs) {
+                        return Convolve(lhs_coefs, lhs_coefs, mode);
+                    }
+                }
+                return Convolve(lhs_coefs, rhs.Coefficients(), mode);
+            }();
+            res.monoms_.reserve(coefs.size());
+            for (size_t ind = 0; ind < coefs.size(); ++ind) {
+                res.monoms_.emplace_back(std::move(coefs[ind]), low + ind);
+            }
+            return res;
+        }
+        size_t range = monoms_.back().GetDegree() + rhs.monoms_.back().GetDegree() - low + 1;
+        size_t products = monoms_.size() * rhs.monoms_.size();
+        if (range > products) {
+            std::vector<Monomial<R, PowFunction>> buff;
+            buff.reserve(products);
+            ForEachProduct(rhs, [&buff](auto&& product, size_t degree) {
+                buff.emplace_back(std::move(product), degree);
+            });
+            res.Assign(std::move(buff));
+            return res;
+        }
+        std::vector<R> coefs(range,
+                             GetZero(monoms_.front().GetCoef() * rhs.monoms_.front().GetCoef()));
+        std::vector<char> present(range, 0);
+        ForEachProduct(rhs, [&](auto&& product, size_t degree) {
+            coefs[degree - low] += product;
+            present[degree - low] = 1;
+        });
+        for (size_t ind = 0; ind < range; ++ind) {
+            if (present[ind]) {
+                res.monoms_.emplace_back(std::move(coefs[ind]), low + ind);
+            }
+        }
+        return res;
+    }
+
+    void RemoveZeros() {
+        std::erase_if(monoms_, [](const auto& monom) { return IsZero(monom.GetCoef()); });
+    }
+
+    size_t Size() const {
+        return monoms_.size();
+    }
+
+    friend bool operator==(const SparseCoefficients& lhs, const SparseCoefficients& rhs) {
+        return lhs.monoms_ == rhs.monoms_;
+    }
+
+private:
+    bool IsContiguous() const {
+        return monoms_.back().GetDegree() - monoms_.front().GetDegree() + 1 == monoms_.size();
+    }
+
+    // Calls f(product, degree) for every pair of terms of *this and rhs. A square of exact
+    // commutative coefficients visits every two distinct terms once, doubling the product.
+    template <typename U, typename F>
+    void ForEachProduct(const SparseCoefficients<U, PowFunction>& rhs, F&& f) const {
+        if constexpr (std::is_same_v<T, U> && is_exact_ring<T>::value &&
+                      is_commutative<T>::value) {
+            if (this == &rhs) {
+                for (size_t i = 0; i < monoms_.size(); ++i) {
+                    const T& coef = monoms_[i].GetCoef();
+                    size_t degree = monoms_[i].GetDegree();
+                    f(coef * coef, 2 * degree);
+                    for (size_t j = i + 1; j < monoms_.size(); ++j) {
+                        auto product = coef * monoms_[j].GetCoef();
+                        f(product + product, degree + monoms_[j].GetDegree());
+                    }
+                }
+                return;
+            }
+        }
+        for (const auto& monom_1 : monoms_) {
+            for (const auto& monom_2 : rhs.monoms_) {
+                f(monom_1.GetCoef() * monom_2.GetCoef(),
+                  monom_1.GetDegree() + monom_2.GetDegree());
+            }
+        }
+    }
+
+    std::vector<T> Coefficients() const {
+        std::vector<T> coefs;
+        coefs.reserve(monoms_.size());
+        for (const auto& monom : monoms_) {
+            coefs.push_back(monom.GetCoef());
+        }
+        return coefs;
+    }
+
+    // Calls emit(degree) for every degree of the sources in ascending order, scanning
+    // all of them for the next one when there are few and using a heap otherwise
+    template <typename F>
+    static void UniteDegrees(const std::vector<const SparseCoefficients*>& sources, F&& emit) {
+        if (sources.size() <= kLinearUnionSources) {
+            using Iterator = typename std::vector<Monomial<T, PowFunction>>::const_iterator;
+            std::vector<std::pair<Iterator, Iterator>> cursors;
+            for (const auto* source : sources) {
+                cursors.emplace_back(source->monoms_.begin(), source->monoms_.end());
+            }
+            while (!cursors.empty()) {
+                size_t degree = cursors.front().first->GetDegree();
+                for (const auto& cursor : cursors) {
+                    degree = std::min(degree, cursor.first->GetDegree());
+                }
+                emit(degree);
+                for (size_t i = 0; i < cursors.size();) {
+                    auto& [it, end] = cursors[i];
+                    if (it->GetDegree() == degree && ++it == end) {
+                        cursors[i] = cursors.back();
+                        cursors.pop_back();
+                    } else {
+                        ++i;
+                    }
+                }
+            }
+            return;
+        }
+        using Entry = std::pair<size_t, size_t>;  // degree, source
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> heap;
+        std::vector<size_t> positions(sources.size(), 0);
+        for (size_t source = 0; source < sources.size(); ++source) {
+            heap.emplace(sources[source]->monoms_.front().GetDegree(), source);
+        }
+        size_t last = 0;
+        bool first = true;
+        while (!heap.empty()) {
+            auto [degree, source] = heap.top();
+            heap.pop();
+            if (first || degree != last) {
+                emit(degree);
+                last = degree;
+                first = false;
+            }
+            const auto& monoms = sources[source]->monoms_;
+            if (++positions[source] < monoms.size()) {
+                heap.emplace(monoms[positions[source]].GetDegree(), source);
+            }
+        }
+    }
+
+    // The term of the given degree at or after it, which must exist. Short distances are
+    // walked, longer ones covered by doubling steps and binary search, so k lookups
+    // along n sorted terms cost O(k log(n / k)).
+    template <typename Iterator>
+    static Iterator Gallop(Iterator it, Iterator end, size_t degree) {
+        for (size_t walked = 0; walked < 8; ++walked, ++it) {
+            if (it->GetDegree() >= degree) {
+                return it;
+            }
+        }
+        size_t step = 1;
+        while (step < static_cast<size_t>(end - it) && it[step - 1].GetDegree() < degree) {
+            it += step;
+            step *= 2;
+        }
+        auto last = it + std::min(step, static_cast<size_t>(end - it));
+        return std::lower_bound(it, last, degree, [](const auto& monom, size_t value) {
+            return monom.GetDegree() < value;
+        });
+    }
+
+    typename std::vector<Monomial<T, PowFunction>>::iterator LowerBound(size_t degree) {
+        return std::lower_bound(
+            monoms_.begin(), monoms_.end(), degree,
+            [](const auto& monom, size_t value) { return monom.GetDegree() < value; });
+    }
+
+    std::vector<Monomial<T, PowFunction>> monoms_;
+};
+
+// Contiguous coefficient vector indexed by degree. Absent and zero coefficients are
+// indistinguishable here: ForEach skips zeros and trailing zeros do not affect equality.
+template <typename T, typename PowFunction>
+class DenseCoefficients {
+public:
+    template <typename U, typename OtherPow>
+    friend class DenseCoefficients;
+
+    void Assign(std::vector<Monomial<T, PowFunction>> monoms) {
+        coefs_.clear();
+        if (monoms.empty()) {
+            return;
+        }
+        auto highest = std::max_element(
+            monoms.begin(), monoms.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.GetDegree() < rhs.GetDegree(); });
+        coefs_.resize(highest->GetDegree() + 1, GetZero(monoms.front().GetCoef()));
+        for (const auto& monom : monoms) {
+            coefs_[monom.GetDegree()] += monom.GetCoef();
+        }
+    }
+
+    template <typename U>
+    void Add(size_t degree, const U& coef) {
+        T value(coef);
+        if (degree >= coefs_.size()) {
+            coefs_.resize(degree + 1, GetZero(value));
+        }
+        coefs_[degree] += value;
+    }
+
+    template <typename U, typename F>
+    void Merge(const DenseCoefficients<U, PowFunction>& other, F&& f) {
+        for (size_t degree = 0; degree < other.coefs_.size(); ++degree) {
+            Add(degree, f(other.coefs_[degree]));
+        }
+    }
+
+    // Sized once to the longest container, then every container is added in one sweep.
+    // Sources may include *this.
+    template <typename Terms>
+    void AssignSum(const Terms& terms) {
+        size_t size = 0;
+        const T* example = nullptr;
+        terms([&size, &example](const DenseCoefficients& source, const auto&) {
+            size = std::max(size, source.coefs_.size());
+            if (!example && !source.coefs_.empty()) {
+                example = &source.coefs_.front();
+            }
+        });
+        std::vector<T> sum;
+        if (example) {
+            sum.resize(size, GetZero(*example));
+        }
+        terms([&sum](const DenseCoefficients& source, const auto& f) {
+            for (size_t degree = 0; degree < source.coefs_.size(); ++degree) {
+                sum[degree] += f(source.coefs_[degree]);
+            }
+        });
+        coefs_ = std::move(sum);
+    }
+
+    template <typename F>
+    void ForEach(F&& f) const {
+        for (size_t degree = 0; degree < coefs_.size(); ++degree) {
+            if (!IsZero(coefs_[degree])) {
+                f(degree, coefs_[degree]);
+            }
+        }
+    }
+
+    template <typename F>
+    void ForEachReversed(F&& f) const {
+        for (size_t degree = coefs_.size(); degree-- > 0;) {
+            if (!IsZero(coefs_[degree])) {
+                f(degree, coefs_[degree]);
+            }
+        }
+    }
+
+    template <typename F>
+    void Transform(F&& f) {
+        for (auto& coef : coefs_) {
+            f(coef);
+        }
+    }
+
+    template <typename R, typename F>
+    DenseCoefficients<R, PowFunction> Map(F&& f) const {
+        DenseCoefficients<R, PowFunction> res;
+        res.coefs_.reserve(coefs_.size());
+        for (const auto& coef : coefs_) {
+            res.coefs_.push_back(f(coef));
+        }
+        return res;
+    }
+
+    template <typename U>
+    DenseCoefficients<MultiplyType<T, U>, PowFunction> Multiply(
+        const DenseCoefficients<U, PowFunction>& rhs, ConvolutionMode mode) const {
+        DenseCoefficients<MultiplyType<T, U>, PowFunction> res;
+        res.coefs_ = Convolve(coefs_, rhs.coefs_, mode);
+        return res;
+    }
+
+    void RemoveZeros() {
+        while (!coefs_.empty() && IsZero(coefs_.back())) {
+            coefs_.pop_back();
+        }
+    }
+
+    size_t Size() const {
+        return coefs_.size();
+    }
+
+    const std::vector<T>& Coefficients() const {
+        return coefs_;
+    }
+
+    std::vector<T>& Coefficients() {
+        return coefs_;
+    }
+
+    friend bool operator==(const DenseCoefficients& lhs, const DenseCoefficients& rhs) {
+        const auto& longer = lhs.coefs_.size() >= rhs.coefs_.size() ? lhs.coefs_ : rhs.coefs_;
+        const auto& shorter = lhs.coefs_.size() >= rhs.coefs_.size() ? rhs.coefs_ : lhs.coefs_;
+        for (size_t i = 0; i < shorter.size(); ++i) {
+            if (!(longer[i] == shorter[i])) {
+                return false;
+            }
+        }
+        for (size_t i = shorter.size(); i < longer.size(); ++i) {
+            if (!IsZero(longer[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<T> coefs_;
+};
+
+struct SparseStorage {
+    template <typename T, typename PowFunction>
+    using Container = SparseCoefficients<T, PowFunction>;
+};
+
+struct DenseStorage {
+    template <typename T, typename PowFunction>
+    using Container = DenseCoefficients<T, PowFunction>;
+};
+
+}  // namespace SingleVariable
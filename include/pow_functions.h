@@ -0,0 +1,145 @@
+#pragma once
+
+#include <any>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <vector>
+
+#include "complex_type.h"
+
+// PowFunction policies beyond DefaultPow and BinaryPow of mp_fwd.h, used by Monomial
+// evaluation; Polynomial evaluation has its own chain of powers. All of them work
+// through operator*=, which reuses a per-thread scratch buffer for matrices of up to
+// kProductScratchBytes, see matrix.h. For those the matrices a call allocates are the
+// ones named below whatever the exponent is; larger products allocate one matrix each.
+
+// Right-to-left square-and-multiply over two values, the running square and the result,
+// both updated in place. Allocates two copies of object.
+struct IterativePow {
+    template <typename T>
+    T operator()(const T& object, size_t pow) const {
+        if (pow == 0) {
+            return GetOne(object);
+        }
+        T square(object);
+        for (; pow % 2 == 0; pow /= 2) {
+            square *= square;
+        }
+        T res(square);
+        for (pow /= 2; pow != 0; pow /= 2) {
+            square *= square;
+            if (pow % 2 == 1) {
+                res *= square;
+            }
+        }
+        return res;
+    }
+};
+
+// Window width of SlidingWindowPow for an exponent of the given bit length: the table
+// of 2^(width - 1) odd powers pays off once it saves more multiplications than it costs
+inline size_t SlidingWindowWidth(size_t bits) {
+    if (bits <= 8) {
+        return 1;
+    }
+    return bits <= 24 ? 2 : 3;
+}
+
+// Left-to-right sliding window: the exponent is cut into windows that start and end with
+// a set bit, each costing one multiplication by a precomputed odd power of object
+// instead of one per set bit. Allocates the table of odd powers and the result.
+struct SlidingWindowPow {
+    template <typename T>
+    T operator()(const T& object, size_t pow) const {
+        if (pow == 0) {
+            return GetOne(object);
+        }
+        size_t bits = std::bit_width(pow);
+        size_t width = SlidingWindowWidth(bits);
+        std::vector<T> odd{object};  // odd[i] = object^(2i + 1)
+        if (width > 1) {
+            size_t count = size_t{1} << (width - 1);
+            odd.reserve(count);
+            T square = object * object;
+            while (odd.size() < count) {
+                odd.push_back(odd.back() * square);
+            }
+        }
+
+        // Window ending at the highest set bit below position end
+        auto window_start = [pow, width](size_t end) {
+            size_t start = end > width ? end - width : 0;
+            while (((pow >> start) & 1) == 0) {
+                ++start;
+            }
+            return start;
+        };
+        auto window_value = [pow](size_t start, size_t end) {
+            return (pow >> start) & ((size_t{1} << (end - start)) - 1);
+        };
+
+        size_t end = bits;
+        size_t start = window_start(end);
+        T res(odd[window_value(start, end) / 2]);
+        for (end = start; end != 0;) {
+            if (((pow >> (end - 1)) & 1) == 0) {
+                res *= res;
+                --end;
+                continue;
+            }
+            start = window_start(end);
+            for (size_t i = start; i < end; ++i) {
+                res *= res;
+            }
+            res *= odd[window_value(start, end) / 2];
+            end = start;
+        }
+        return res;
+    }
+};
+
+// For one base raised to many exponents, as when many monomials are evaluated at one
+// point. The repeated squares object^(2^i) of the last base are kept in a table
+// owned by the TablePow object, so every power of that base costs one multiplication per
+// set bit of the exponent after the lowest. The table grows to bit_width of the largest
+// exponent seen and is dropped with the object, by Clear() or when another base or type
+// comes. Types without operator== get a fresh table on every call. Monomials share one
+// TablePow when it is passed to Monomial::operator()(point, pow); on their own they use
+// a new object, and so a new table, per call.
+class TablePow {
+public:
+    template <typename T>
+    T operator()(const T& object, size_t pow) {
+        if (pow == 0) {
+            return GetOne(object);
+        }
+        auto* squares = std::any_cast<std::vector<T>>(&squares_);
+        bool same_base = false;
+        if constexpr (std::equality_comparable<T>) {
+            same_base = squares != nullptr && squares->front() == object;
+        }
+        if (!same_base) {
+            squares = &squares_.emplace<std::vector<T>>(1, object);
+        }
+        size_t bits = std::bit_width(pow);
+        while (squares->size() < bits) {
+            squares->push_back(squares->back() * squares->back());
+        }
+        size_t bit = std::countr_zero(pow);
+        T res((*squares)[bit]);
+        for (++bit; bit < bits; ++bit) {
+            if ((pow >> bit) & 1) {
+                res *= (*squares)[bit];
+            }
+        }
+        return res;
+    }
+
+    void Clear() {
+        squares_.reset();
+    }
+
+private:
+    std::any squares_;  // std::vector<T> of object^(2^i)
+};
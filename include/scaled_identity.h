@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "mp_fwd.h"  // Forward declaration
+
+// scalar * I kept symbolic: a rows x cols matrix with scalar on the main diagonal and
+// zeros elsewhere, stored as its shape and the scalar. Scaling it costs O(1), adding it
+// to a matrix touches only the diagonal and multiplying by it scales the other factor,
+// see matrix.h. GetLazyOne and GetLazyZero hand it out for matrices instead of a full
+// identity or zero matrix.
+template <typename T>
+class ScaledIdentity {
+public:
+    ScaledIdentity(size_t rows, size_t cols, T scalar)
+        : rows_(rows), cols_(cols), scalar_(std::move(scalar)) {
+    }
+
+    size_t Rows() const {
+        return rows_;
+    }
+
+    size_t Columns() const {
+        return cols_;
+    }
+
+    // Length of the main diagonal
+    size_t Diagonal() const {
+        return rows_ < cols_ ? rows_ : cols_;
+    }
+
+    const T& Scalar() const {
+        return scalar_;
+    }
+
+private:
+    size_t rows_;
+    size_t cols_;
+    T scalar_;
+};
+
+template <typename T>
+struct is_scaled_identity : std::false_type {};
+
+template <typename T>
+struct is_scaled_identity<ScaledIdentity<T>> : std::true_type {};
+
+template <typename T, typename U>
+    requires(!is_scaled_identity<U>::value &&
+             std::is_convertible_v<MultiplyType<const U&, const T&>, T>)
+ScaledIdentity<T> operator*(const U& multiplyer, const ScaledIdentity<T>& identity) {
+    return ScaledIdentity<T>(identity.Rows(), identity.Columns(),
+                             multiplyer * identity.Scalar());
+}
+
+template <typename T, typename U>
+    requires(!is_scaled_identity<U>::value &&
+             std::is_convertible_v<MultiplyType<const T&, const U&>, T>)
+ScaledIdentity<T> operator*(const ScaledIdentity<T>& identity, const U& multiplyer) {
+    return ScaledIdentity<T>(identity.Rows(), identity.Columns(),
+                             identity.Scalar() * multiplyer);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// x86 kernels are compiled for their instruction set through target attributes and
+// picked at run time, so the library works unchanged without -march flags
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define POLYNOMIAL_X86_DISPATCH 1
+#define POLYNOMIAL_AVX2 __attribute__((target("avx2,fma")))
+#define POLYNOMIAL_AVX512 __attribute__((target("avx512f")))
+#endif
+
+#ifdef POLYNOMIAL_X86_DISPATCH
+
+inline bool HasAvx2Fma() {
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+}
+
+inline bool HasAvx512() {
+    static const bool supported = __builtin_cpu_supports("avx512f");
+    return supported;
+}
+
+// Each wrapper covers one register width: Load, Store, Broadcast, Add,
+// MulAdd(a, b, c) = a * b + c and Multiply. Loads and stores are unaligned.
+
+struct Avx2Double {
+    using Type = __m256d;
+    static constexpr size_t kWidth = 4;
+    POLYNOMIAL_AVX2 static Type Load(const double* ptr) {
+        return _mm256_loadu_pd(ptr);
+    }
+    POLYNOMIAL_AVX2 static void Store(double* ptr, Type value) {
+        _mm256_storeu_pd(ptr, value);
+    }
+    POLYNOMIAL_AVX2 static Type Broadcast(double value) {
+        return _mm256_set1_pd(value);
+    }
+    POLYNOMIAL_AVX2 static Type Add(Type a, Type b) {
+        return _mm256_add_pd(a, b);
+    }
+    POLYNOMIAL_AVX2 static Type MulAdd(Type a, Type b, Type c) {
+        return _mm256_fmadd_pd(a, b, c);
+    }
+    POLYNOMIAL_AVX2 static Type Multiply(Type a, Type b) {
+        return _mm256_mul_pd(a, b);
+    }
+};
+
+struct Avx2Float {
+    using Type = __m256;
+    static constexpr size_t kWidth = 8;
+    POLYNOMIAL_AVX2 static Type Load(const float* ptr) {
+        return _mm256_loadu_ps(ptr);
+    }
+    POLYNOMIAL_AVX2 static void Store(float* ptr, Type value) {
+        _mm256_storeu_ps(ptr, value);
+    }
+    POLYNOMIAL_AVX2 static Type Broadcast(float value) {
+        return _mm256_set1_ps(value);
+    }
+    POLYNOMIAL_AVX2 static Type Add(Type a, Type b) {
+        return _mm256_add_ps(a, b);
+    }
+    POLYNOMIAL_AVX2 static Type MulAdd(Type a, Type b, Type c) {
+        return _mm256_fmadd_ps(a, b, c);
+    }
+    POLYNOMIAL_AVX2 static Type Multiply(Type a, Type b) {
+        return _mm256_mul_ps(a, b);
+    }
+};
+
+// AVX2 has no 64-bit multiply, so 64-bit integers stay on the portable kernels.
+// The low half of a product does not depend on signedness, so int32_t uses this too.
+struct Avx2Uint32 {
+    using Type = __m256i;
+    static constexpr size_t kWidth = 8;
+    POLYNOMIAL_AVX2 static Type Load(const uint32_t* ptr) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    }
+    POLYNOMIAL_AVX2 static void Store(uint32_t* ptr, Type value) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value);
+    }
+    POLYNOMIAL_AVX2 static Type Broadcast(uint32_t value) {
+        return _mm256_set1_epi32(static_cast<int>(value));
+    }
+    POLYNOMIAL_AVX2 static Type Add(Type a, Type b) {
+        return _mm256_add_epi32(a, b);
+    }
+    POLYNOMIAL_AVX2 static Type MulAdd(Type a, Type b, Type c) {
+        return _mm256_add_epi32(_mm256_mullo_epi32(a, b), c);
+    }
+    POLYNOMIAL_AVX2 static Type Multiply(Type a, Type b) {
+        return _mm256_mullo_epi32(a, b);
+    }
+};
+
+struct Avx512Double {
+    using Type = __m512d;
+    static constexpr size_t kWidth = 8;
+    POLYNOMIAL_AVX512 static Type Load(const double* ptr) {
+        return _mm512_loadu_pd(ptr);
+    }
+    POLYNOMIAL_AVX512 static void Store(double* ptr, Type value) {
+        _mm512_storeu_pd(ptr, value);
+    }
+    POLYNOMIAL_AVX512 static Type Broadcast(double value) {
+        return _mm512_set1_pd(value);
+    }
+    POLYNOMIAL_AVX512 static Type Add(Type a, Type b) {
+        return _mm512_add_pd(a, b);
+    }
+    POLYNOMIAL_AVX512 static Type MulAdd(Type a, Type b, Type c) {
+        return _mm512_fmadd_pd(a, b, c);
+    }
+    POLYNOMIAL_AVX512 static Type Multiply(Type a, Type b) {
+        return _mm512_mul_pd(a, b);
+    }
+};
+
+struct Avx512Float {
+    using Type = __m512;
+    static constexpr size_t kWidth = 16;
+    POLYNOMIAL_AVX512 static Type Load(const float* ptr) {
+        return _mm512_loadu_ps(ptr);
+    }
+    POLYNOMIAL_AVX512 static void Store(float* ptr, Type value) {
+        _mm512_storeu_ps(ptr, value);
+    }
+    POLYNOMIAL_AVX512 static Type Broadcast(float value) {
+        return _mm512_set1_ps(value);
+    }
+    POLYNOMIAL_AVX512 static Type Add(Type a, Type b) {
+        return _mm512_add_ps(a, b);
+    }
+    POLYNOMIAL_AVX512 static Type MulAdd(Type a, Type b, Type c) {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+    POLYNOMIAL_AVX512 static Type Multiply(Type a, Type b) {
+        return _mm512_mul_ps(a, b);
+    }
+};
+
+struct Avx512Uint32 {
+    using Type = __m512i;
+    static constexpr size_t kWidth = 16;
+    POLYNOMIAL_AVX512 static Type Load(const uint32_t* ptr) {
+        return _mm512_loadu_si512(ptr);
+    }
+    POLYNOMIAL_AVX512 static void Store(uint32_t* ptr, Type value) {
+        _mm512_storeu_si512(ptr, value);
+    }
+    POLYNOMIAL_AVX512 static Type Broadcast(uint32_t value) {
+        return _mm512_set1_epi32(static_cast<int>(value));
+    }
+    POLYNOMIAL_AVX512 static Type Add(Type a, Type b) {
+        return _mm512_add_epi32(a, b);
+    }
+    POLYNOMIAL_AVX512 static Type MulAdd(Type a, Type b, Type c) {
+        return _mm512_add_epi32(_mm512_mullo_epi32(a, b), c);
+    }
+    POLYNOMIAL_AVX512 static Type Multiply(Type a, Type b) {
+        return _mm512_mullo_epi32(a, b);
+    }
+};
+
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "aligned_allocator.h"
+#include "gemm.h"
+#include "mp_fwd.h"  // Forward declaration
+
+// Square blocks up to this size are multiplied by GemmParallel
+inline constexpr size_t kStrassenCutoff = 256;
+
+// Smallest square product worth one level of Strassen-Winograd
+inline constexpr size_t kStrassenThreshold = 2 * kStrassenCutoff;
+
+// Elements of scratch memory StrassenMultiply needs for n x n operands
+inline size_t StrassenWorkspace(size_t n) {
+    size_t size = 0;
+    while (n > kStrassenCutoff) {
+        n /= 2;
+        size += 2 * n * n;
+    }
+    return size;
+}
+
+// out = lhs + rhs or lhs - rhs over size x size blocks, out may be lhs or rhs
+template <typename T>
+void AddBlocks(const T* lhs, size_t ldl, const T* rhs, size_t ldr, T* out, size_t ldo,
+               size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            out[i * ldo + j] = lhs[i * ldl + j] + rhs[i * ldr + j];
+        }
+    }
+}
+
+template <typename T>
+void SubtractBlocks(const T* lhs, size_t ldl, const T* rhs, size_t ldr, T* out, size_t ldo,
+                    size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            out[i * ldo + j] = lhs[i * ldl + j] - rhs[i * ldr + j];
+        }
+    }
+}
+
+// C = A * B for n x n blocks. Odd sizes peel the last row and column, which are then
+// finished by Gemm. Even sizes run the 22-step schedule of Boyer, Dumas, Pernet and Zhou
+// for Winograd's variant: 7 half-size products, 15 additions and two temporaries X and Y
+// at the front of workspace, the rest of which goes to the recursive calls.
+template <typename T>
+void StrassenRecurse(const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc, size_t n,
+                     T* workspace, size_t threads) {
+    if (n <= kStrassenCutoff) {
+        for (size_t i = 0; i < n; ++i) {
+            std::fill_n(c + i * ldc, n, T{});
+        }
+        GemmParallel(ConstMatrixView<T>(a, n, n, lda), ConstMatrixView<T>(b, n, n, ldb), c, ldc,
+                     threads);
+        return;
+    }
+    if (n % 2 == 1) {
+        size_t m = n - 1;
+        StrassenRecurse(a, lda, b, ldb, c, ldc, m, workspace, threads);
+        ConstMatrixView<T> lhs(a, n, n, lda);
+        ConstMatrixView<T> rhs(b, n, n, ldb);
+        Gemm(lhs.Block(0, m, m, 1), rhs.Block(m, 0, 1, m), c, ldc);
+        for (size_t i = 0; i < n; ++i) {
+            c[i * ldc + m] = T{};
+        }
+        std::fill_n(c + m * ldc, m, T{});
+        Gemm(lhs, rhs.Block(0, m, n, 1), c + m, ldc);
+        Gemm(lhs.Block(m, 0, 1, n), rhs.Block(0, 0, n, m), c + m * ldc, ldc);
+        return;
+    }
+
+    size_t h = n / 2;
+    const T* a11 = a;
+    const T* a12 = a + h;
+    const T* a21 = a + h * lda;
+    const T* a22 = a21 + h;
+    const T* b11 = b;
+    const T* b12 = b + h;
+    const T* b21 = b + h * ldb;
+    const T* b22 = b21 + h;
+    T* c11 = c;
+    T* c12 = c + h;
+    T* c21 = c + h * ldc;
+    T* c22 = c21 + h;
+    T* x = workspace;
+    T* y = x + h * h;
+    T* rest = y + h * h;
+    auto product = [&](const T* lhs, size_t ldl, const T* rhs, size_t ldr, T* out) {
+        StrassenRecurse(lhs, ldl, rhs, ldr, out, ldc, h, rest, threads);
+    };
+
+    SubtractBlocks(a11, lda, a21, lda, x, h, h);  // S3
+    SubtractBlocks(b22, ldb, b12, ldb, y, h, h);  // T3
+    product(x, h, y, h, c21);                     // P7
+    AddBlocks(a21, lda, a22, lda, x, h, h);       // S1
+    SubtractBlocks(b12, ldb, b11, ldb, y, h, h);  // T1
+    product(x, h, y, h, c22);                     // P5
+    SubtractBlocks(x, h, a11, lda, x, h, h);      // S2
+    SubtractBlocks(b22, ldb, y, h, y, h, h);      // T2
+    product(x, h, y, h, c12);                     // P6
+    SubtractBlocks(a12, lda, x, h, x, h, h);      // S4
+    product(x, h, b22, ldb, c11);                 // P3
+    StrassenRecurse(a11, lda, b11, ldb, x, h, h, rest, threads);  // P1
+    AddBlocks(x, h, c12, ldc, c12, ldc, h);       // U2 = P1 + P6
+    AddBlocks(c12, ldc, c21, ldc, c21, ldc, h);   // U3 = U2 + P7
+    AddBlocks(c12, ldc, c22, ldc, c12, ldc, h);   // U4 = U2 + P5
+    AddBlocks(c21, ldc, c22, ldc, c22, ldc, h);   // U7 = U3 + P5, C22
+    AddBlocks(c12, ldc, c11, ldc, c12, ldc, h);   // U5 = U4 + P3, C12
+    SubtractBlocks(y, h, b21, ldb, y, h, h);      // T4
+    product(a22, lda, y, h, c11);                 // P4
+    SubtractBlocks(c21, ldc, c11, ldc, c21, ldc, h);  // U6 = U3 - P4, C21
+    product(a12, lda, b21, ldb, c11);                 // P2
+    AddBlocks(x, h, c11, ldc, c11, ldc, h);           // U1 = P1 + P2, C11
+}
+
+// C = A * B for n x n operands over an exact ring, see is_exact_ring. Signed integers
+// are multiplied as unsigned where kMultipliedAsUnsigned allows it: the result is the
+// same and intermediate overflow is defined.
+template <typename T>
+void StrassenMultiply(const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc, size_t n,
+                      size_t threads = 0) {
+    static_assert(is_exact_ring<T>::value, "Strassen-Winograd needs exact arithmetic");
+    if constexpr (kMultipliedAsUnsigned<T>) {
+        using U = std::make_unsigned_t<T>;
+        StrassenMultiply(reinterpret_cast<const U*>(a), lda, reinterpret_cast<const U*>(b), ldb,
+                         reinterpret_cast<U*>(c), ldc, n, threads);
+    } else {
+        std::vector<T, AlignedAllocator<T>> workspace(StrassenWorkspace(n));
+        StrassenRecurse(a, lda, b, ldb, c, ldc, n, workspace.data(), threads);
+    }
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for data-parallel loops. Every worker owns a deque of index ranges:
+// it takes work from the back of its own deque, splitting large ranges in half and
+// leaving the upper half to be stolen, and steals from the front of the others when it
+// runs dry. The thread calling ParallelFor works on its own loop until it is done.
+class ThreadPool {
+public:
+    // threads counts the calling thread, so threads - 1 workers are started
+    explicit ThreadPool(size_t threads) : queues_(std::max<size_t>(threads, 1) - 1) {
+        workers_.reserve(queues_.size());
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            workers_.emplace_back([this, i] { WorkerLoop(i); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    size_t Size() const {
+        return workers_.size() + 1;
+    }
+
+    // Calls f(i) for every i in [0, count) on at most threads threads (0 means all of
+    // them) and returns when all calls are done. The first exception is rethrown here.
+    template <typename F>
+    void ParallelFor(size_t count, F&& f, size_t threads = 0) {
+        if (count == 0) {
+            return;
+        }
+        threads = threads == 0 ? Size() : std::min(threads, Size());
+        threads = std::min(threads, count);
+        if (threads == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                f(i);
+            }
+            return;
+        }
+
+        Job job;
+        job.run = [&f](size_t i) { f(i); };
+        job.remaining = count;
+        job.workers = threads - 1;
+        size_t chunk = count / threads;
+        {
+            std::lock_guard lock(mutex_);
+            for (size_t w = 0; w < job.workers; ++w) {
+                queues_[w].push_back({&job, chunk * (w + 1), chunk * (w + 2)});
+            }
+            queues_[job.workers - 1].back().end = count;
+            ++version_;
+        }
+        wake_.notify_all();
+
+        Execute({&job, 0, chunk}, kCaller);
+        while (job.remaining.load() != 0) {
+            Task task;
+            if (TakeTask(kCaller, &job, task)) {
+                Execute(task, kCaller);
+            } else {
+                std::unique_lock lock(job.mutex);
+                job.done.wait(lock, [&job] { return job.remaining.load() == 0; });
+            }
+        }
+        // The last worker may still hold the mutex it signalled through
+        std::lock_guard lock(job.mutex);
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+    // Shared pool used by Matrix operations, sized to the hardware by default
+    static ThreadPool& Global() {
+        std::lock_guard lock(GlobalMutex());
+        auto& pool = GlobalPool();
+        if (!pool) {
+            pool = std::make_unique<ThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+        }
+        return *pool;
+    }
+
+    // Replaces the shared pool. Must not be called while it runs a loop.
+    static void SetGlobalThreads(size_t threads) {
+        std::lock_guard lock(GlobalMutex());
+        GlobalPool() = std::make_unique<ThreadPool>(threads);
+    }
+
+private:
+    struct Job {
+        std::function<void(size_t)> run;
+        std::atomic<size_t> remaining = 0;
+        size_t workers = 0;  // only workers with a smaller index take part
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        Job* job = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    static constexpr size_t kCaller = static_cast<size_t>(-1);
+
+    static std::mutex& GlobalMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::unique_ptr<ThreadPool>& GlobalPool() {
+        static std::unique_ptr<ThreadPool> pool;
+        return pool;
+    }
+
+    // Own deque first, then the others. The caller only helps with its own job.
+    bool TakeTask(size_t self, const Job* only, Task& task) {
+        std::lock_guard lock(mutex_);
+        if (self != kCaller && !queues_[self].empty()) {
+            task = queues_[self].back();
+            queues_[self].pop_back();
+            return true;
+        }
+        size_t start = self == kCaller ? 0 : self;
+        for (size_t k = 1; k <= queues_.size(); ++k) {
+            auto& victim = queues_[(start + k) % queues_.size()];
+            for (auto it = victim.begin(); it != victim.end(); ++it) {
+                bool allowed = only ? it->job == only : self < it->job->workers;
+                if (allowed) {
+                    task = *it;
+                    victim.erase(it);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Workers keep halving the range and leave the upper halves to thieves
+    void Execute(Task task, size_t self) {
+        Job& job = *task.job;
+        while (self != kCaller && task.end - task.begin > 1) {
+            size_t mid = task.begin + (task.end - task.begin) / 2;
+            {
+                std::lock_guard lock(mutex_);
+                queues_[self].push_back({&job, mid, task.end});
+                ++version_;
+            }
+            wake_.notify_all();
+            task.end = mid;
+        }
+        for (size_t i = task.begin; i < task.end; ++i) {
+            try {
+                job.run(i);
+            } catch (...) {
+                std::lock_guard lock(job.mutex);
+                if (!job.error) {
+                    job.error = std::current_exception();
+                }
+            }
+        }
+        std::lock_guard lock(job.mutex);
+        if (job.remaining.fetch_sub(task.end - task.begin) == task.end - task.begin) {
+            job.done.notify_all();
+        }
+    }
+
+    void WorkerLoop(size_t self) {
+        while (true) {
+            size_t seen;
+            {
+                std::lock_guard lock(mutex_);
+                seen = version_;
+            }
+            Task task;
+            if (TakeTask(self, nullptr, task)) {
+                Execute(task, self);
+                continue;
+            }
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || version_ != seen; });
+            if (stop_) {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::deque<Task>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    size_t version_ = 0;
+    bool stop_ = false;
+};
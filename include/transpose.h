@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Tiles of this size are transposed by plain loops: both the rows read and the columns
+// written stay in L1
+inline constexpr size_t kTransposeBlock = 32;
+
+// out(j, i) = in(i, j) for rows x cols of in, tile by tile
+template <typename T>
+void TransposeBlocked(const T* in, size_t in_stride, T* out, size_t out_stride, size_t rows,
+                      size_t cols) {
+    for (size_t ib = 0; ib < rows; ib += kTransposeBlock) {
+        size_t i_end = std::min(rows, ib + kTransposeBlock);
+        for (size_t jb = 0; jb < cols; jb += kTransposeBlock) {
+            size_t j_end = std::min(cols, jb + kTransposeBlock);
+            for (size_t i = ib; i < i_end; ++i) {
+                for (size_t j = jb; j < j_end; ++j) {
+                    out[j * out_stride + i] = in[i * in_stride + j];
+                }
+            }
+        }
+    }
+}
+
+// Swaps a(i, j) with b(j, i), where a is rows x cols and b is cols x rows. Halving the
+// longer side keeps both blocks cache-sized at some depth whatever the cache is.
+template <typename T>
+void SwapTransposed(T* a, T* b, size_t stride, size_t rows, size_t cols) {
+    if (rows <= kTransposeBlock && cols <= kTransposeBlock) {
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                std::swap(a[i * stride + j], b[j * stride + i]);
+            }
+        }
+    } else if (rows >= cols) {
+        size_t half = rows / 2;
+        SwapTransposed(a, b, stride, half, cols);
+        SwapTransposed(a + half * stride, b + half, stride, rows - half, cols);
+    } else {
+        size_t half = cols / 2;
+        SwapTransposed(a, b, stride, rows, half);
+        SwapTransposed(a + half, b + half * stride, stride, rows, cols - half);
+    }
+}
+
+// Cache-oblivious in-place transpose of an n x n block: transpose both diagonal
+// quarters, then swap the off-diagonal ones through SwapTransposed
+template <typename T>
+void TransposeSquareInPlace(T* a, size_t stride, size_t n) {
+    if (n <= kTransposeBlock) {
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                std::swap(a[i * stride + j], a[j * stride + i]);
+            }
+        }
+        return;
+    }
+    size_t half = n / 2;
+    TransposeSquareInPlace(a, stride, half);
+    TransposeSquareInPlace(a + half * stride + half, stride, n - half);
+    SwapTransposed(a + half, a + half * stride, stride, half, n - half);
+}
+
+// In-place transpose of a dense rows x cols array into cols x rows by following the
+// cycles of the permutation i * cols + j -> j * rows + i. One bit per element marks
+// what has been moved.
+template <typename T>
+void TransposeCycles(T* a, size_t rows, size_t cols) {
+    size_t size = rows * cols;
+    if (size < 3) {
+        return;
+    }
+    std::vector<bool> moved(size);
+    for (size_t start = 1; start + 1 < size; ++start) {
+        if (moved[start]) {
+            continue;
+        }
+        T value = std::move(a[start]);
+        size_t cur = start;
+        do {
+            size_t next = cur % cols * rows + cur / cols;
+            std::swap(value, a[next]);
+            moved[next] = true;
+            cur = next;
+        } while (cur != start);
+    }
+}
@@ -0,0 +1,265 @@
+#include <catch.hpp>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../include/convolution.h"
+#include "../include/matrix.h"
+#include "../include/modint.h"
+#include "../include/polynomial.h"
+#include "structs.h"
+
+template <typename T, typename U>
+std::vector<MultiplyType<T, U>> NaiveConvolve(const std::vector<T>& lhs,
+                                               const std::vector<U>& rhs) {
+    std::vector<MultiplyType<T, U>> res(lhs.size() + rhs.size() - 1,
+                                        GetZero(lhs.front() * rhs.front()));
+    SingleVariable::SchoolbookMultiply(lhs.data(), lhs.size(), rhs.data(), rhs.size(),
+                                       res.data());
+    return res;
+}
+
+template <typename T>
+std::vector<T> RandomCoefficients(size_t size, std::mt19937& gen) {
+    std::uniform_int_distribution<int> dist(-1000, 1000);
+    std::vector<T> res;
+    for (size_t i = 0; i < size; ++i) {
+        res.push_back(T(dist(gen)));
+    }
+    return res;
+}
+
+TEST_CASE("Karatsuba integers") {
+    std::mt19937 gen(7);
+    for (auto [n, m] : std::vector<std::pair<size_t, size_t>>{
+             {1, 1}, {31, 33}, {64, 64}, {100, 1000}, {777, 555}, {1500, 1500}}) {
+        auto lhs = RandomCoefficients<int64_t>(n, gen);
+        auto rhs = RandomCoefficients<int64_t>(m, gen);
+        REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+    }
+    {
+        auto lhs = RandomCoefficients<Int>(300, gen);
+        auto rhs = RandomCoefficients<Int>(200, gen);
+        REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+    }
+    {
+        std::vector<uint64_t> lhs(100, UINT64_MAX);
+        std::vector<uint64_t> rhs(100, UINT64_MAX - 1);
+        REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+    }
+}
+
+TEST_CASE("Karatsuba matrices") {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> dist(-10, 10);
+    std::vector<Matrix<int>> lhs;
+    std::vector<Matrix<int>> rhs;
+    for (size_t i = 0; i < 70; ++i) {
+        lhs.push_back(Matrix<int>{{dist(gen), dist(gen)}, {dist(gen), dist(gen)}});
+        rhs.push_back(Matrix<int>{{dist(gen), dist(gen)}, {dist(gen), dist(gen)}});
+    }
+    REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+}
+
+TEST_CASE("Toom-Cook doubles") {
+    std::mt19937 gen(13);
+    auto lhs = RandomCoefficients<double>(1000, gen);
+    auto rhs = RandomCoefficients<double>(900, gen);
+    std::vector<double> fast(lhs.size() + rhs.size() - 1);
+    SingleVariable::MultiplyUnbalanced(lhs.data(), lhs.size(), rhs.data(), rhs.size(),
+                                       fast.data(), 0.0);
+    auto naive = NaiveConvolve(lhs, rhs);
+    REQUIRE(fast.size() == naive.size());
+    for (size_t i = 0; i < fast.size(); ++i) {
+        REQUIRE(fast[i] == Approx(naive[i]).margin(1e-6));
+    }
+}
+
+TEST_CASE("Toom-Cook integers") {
+    std::mt19937 gen(19);
+    for (auto [n, m] : std::vector<std::pair<size_t, size_t>>{{256, 256}, {1000, 700}}) {
+        auto lhs = RandomCoefficients<int64_t>(n, gen);
+        auto rhs = RandomCoefficients<int64_t>(m, gen);
+        REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+        // Too large for Toom-3 in 32 bits, then small enough
+        auto lhs32 = RandomCoefficients<int32_t>(n, gen);
+        REQUIRE(!SingleVariable::ToomCook3Fits(lhs32.data(), lhs32.data(), n));
+        REQUIRE(SingleVariable::Convolve(lhs32, lhs32) == NaiveConvolve(lhs32, lhs32));
+        for (auto& coef : lhs32) {
+            coef %= 10;
+        }
+        REQUIRE(SingleVariable::ToomCook3Fits(lhs32.data(), lhs32.data(), n));
+        REQUIRE(SingleVariable::Convolve(lhs32, lhs32) == NaiveConvolve(lhs32, lhs32));
+    }
+    auto lhs = RandomCoefficients<ModInt<1000000007>>(800, gen);
+    auto rhs = RandomCoefficients<ModInt<1000000007>>(800, gen);
+    std::vector<ModInt<1000000007>> fast(lhs.size() + rhs.size() - 1);
+    SingleVariable::ToomCook3Multiply(lhs.data(), rhs.data(), lhs.size(), fast.data(),
+                                      ModInt<1000000007>(0));
+    REQUIRE(fast == NaiveConvolve(lhs, rhs));
+}
+
+TEST_CASE("Integer products wrap around") {
+    // a0 + a1 and the products of Karatsuba overflow int64_t; they wrap like uint64_t
+    std::mt19937_64 gen(23);
+    for (size_t n : {64, 300}) {
+        std::vector<int64_t> lhs;
+        std::vector<int64_t> rhs;
+        for (size_t i = 0; i < n; ++i) {
+            lhs.push_back(static_cast<int64_t>(gen()));
+            rhs.push_back(i % 2 == 0 ? INT64_MAX - static_cast<int64_t>(i) : INT64_MIN);
+        }
+        std::vector<uint64_t> lhs_unsigned(lhs.begin(), lhs.end());
+        std::vector<uint64_t> rhs_unsigned(rhs.begin(), rhs.end());
+        auto expected = NaiveConvolve(lhs_unsigned, rhs_unsigned);
+        auto product = SingleVariable::Convolve(lhs, rhs);
+        REQUIRE(product.size() == expected.size());
+        for (size_t i = 0; i < product.size(); ++i) {
+            REQUIRE(static_cast<uint64_t>(product[i]) == expected[i]);
+        }
+        auto square = SingleVariable::Convolve(lhs, lhs);
+        auto expected_square = NaiveConvolve(lhs_unsigned, lhs_unsigned);
+        for (size_t i = 0; i < square.size(); ++i) {
+            REQUIRE(static_cast<uint64_t>(square[i]) == expected_square[i]);
+        }
+    }
+}
+
+TEST_CASE("Fast polynomial product") {
+    std::mt19937 gen(17);
+    auto coefs = RandomCoefficients<int64_t>(500, gen);
+    SingleVariable::Polynomial<int64_t> sparse;
+    SingleVariable::Polynomial<int64_t, DefaultPow, SingleVariable::DenseStorage> dense;
+    std::set<SingleVariable::Monomial<int64_t>> expected;
+    for (size_t i = 0; i < coefs.size(); ++i) {
+        sparse += SingleVariable::Monomial<int64_t>(coefs[i], i + 3);
+        dense += SingleVariable::Monomial<int64_t>(coefs[i], i + 3);
+    }
+    auto square = NaiveConvolve(coefs, coefs);
+    for (size_t i = 0; i < square.size(); ++i) {
+        expected.emplace(square[i], i + 6);
+    }
+    REQUIRE((sparse * sparse).GetMonomials() == expected);
+    REQUIRE((dense * dense).GetMonomials() == expected);
+}
+
+TEST_CASE("NTT") {
+    using Mod = ModInt<998244353>;
+    static_assert(SingleVariable::ntt_traits<Mod>::kEnabled);
+    static_assert(SingleVariable::ntt_traits<Mod>::kRoot == 3);
+    static_assert(!SingleVariable::ntt_traits<ModInt<1000000007>>::kEnabled);
+
+    std::mt19937 gen(19);
+    for (auto [n, m] : std::vector<std::pair<size_t, size_t>>{{64, 64}, {100, 300}, {1000, 999}}) {
+        auto lhs = RandomCoefficients<Mod>(n, gen);
+        auto rhs = RandomCoefficients<Mod>(m, gen);
+        REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+    }
+    {
+        std::vector<Mod> lhs(5000, Mod(998244352));
+        std::vector<Mod> rhs(4000, Mod(998244352));
+        auto res = SingleVariable::Convolve(lhs, rhs);
+        REQUIRE(res.size() == 8999);
+        REQUIRE(res[0] == Mod(1));
+        REQUIRE(res[4500] == Mod(4000));
+    }
+    {
+        using Big = ModInt<1000000007>;
+        auto lhs = RandomCoefficients<Big>(700, gen);
+        auto rhs = RandomCoefficients<Big>(600, gen);
+        REQUIRE(SingleVariable::Convolve(lhs, rhs) == NaiveConvolve(lhs, rhs));
+    }
+}
+
+TEST_CASE("FFT") {
+    std::mt19937 gen(23);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    for (auto [n, m] :
+         std::vector<std::pair<size_t, size_t>>{{64, 64}, {100, 3000}, {2000, 1999}}) {
+        std::vector<double> lhs(n);
+        std::vector<double> rhs(m);
+        std::vector<std::complex<double>> lhs_complex(n);
+        std::vector<std::complex<double>> rhs_complex(m);
+        for (size_t i = 0; i < n; ++i) {
+            lhs[i] = dist(gen);
+            lhs_complex[i] = {dist(gen), dist(gen)};
+        }
+        for (size_t i = 0; i < m; ++i) {
+            rhs[i] = dist(gen);
+            rhs_complex[i] = {dist(gen), dist(gen)};
+        }
+        auto fast = SingleVariable::Convolve(lhs, rhs);
+        auto naive = NaiveConvolve(lhs, rhs);
+        auto fast_complex = SingleVariable::Convolve(lhs_complex, rhs_complex);
+        auto naive_complex = NaiveConvolve(lhs_complex, rhs_complex);
+        REQUIRE(fast.size() == naive.size());
+        REQUIRE(fast_complex.size() == naive_complex.size());
+        for (size_t i = 0; i < fast.size(); ++i) {
+            REQUIRE(std::abs(fast[i] - naive[i]) < 1e-10);
+            REQUIRE(std::abs(fast_complex[i] - naive_complex[i]) < 1e-10);
+        }
+
+        auto exact = SingleVariable::Convolve(lhs, rhs, SingleVariable::ConvolutionMode::kExact);
+        REQUIRE(exact == naive);
+    }
+}
+
+TEST_CASE("Exact polynomial product") {
+    SingleVariable::Polynomial<double, DefaultPow, SingleVariable::DenseStorage> p;
+    for (size_t i = 0; i < 100; ++i) {
+        p += SingleVariable::Monomial<double>(1e9 + static_cast<double>(i) * 1e-3, i);
+    }
+    auto exact = p.Multiply(p, SingleVariable::ConvolutionMode::kExact);
+    auto fast = p * p;
+    std::vector<double> coefs;
+    for (size_t i = 0; i < 100; ++i) {
+        coefs.push_back(1e9 + static_cast<double>(i) * 1e-3);
+    }
+    auto naive = NaiveConvolve(coefs, coefs);
+    for (const auto& monom : exact.GetMonomials()) {
+        REQUIRE(monom.GetCoef() == naive[monom.GetDegree()]);
+    }
+    for (const auto& monom : fast.GetMonomials()) {
+        REQUIRE(monom.GetCoef() == Approx(naive[monom.GetDegree()]));
+    }
+}
+
+TEST_CASE("Squares") {
+    std::mt19937 gen(31);
+    for (size_t n : {1, 2, 17, 31, 64, 333, 1000}) {
+        auto ints = RandomCoefficients<int64_t>(n, gen);
+        auto ints_copy = ints;
+        REQUIRE(SingleVariable::Convolve(ints, ints) == NaiveConvolve(ints, ints_copy));
+
+        auto big = RandomCoefficients<ModInt<1000000007>>(n, gen);
+        auto big_copy = big;
+        REQUIRE(SingleVariable::Convolve(big, big) == NaiveConvolve(big, big_copy));
+
+        auto ntt = RandomCoefficients<ModInt<998244353>>(n, gen);
+        auto ntt_copy = ntt;
+        REQUIRE(SingleVariable::Convolve(ntt, ntt) == NaiveConvolve(ntt, ntt_copy));
+    }
+
+    std::vector<Matrix<int>> matrices;
+    for (int i = 0; i < 40; ++i) {
+        matrices.push_back(Matrix<int>{{i, 1}, {-i, 2 * i}});
+    }
+    auto matrices_copy = matrices;
+    REQUIRE(SingleVariable::Convolve(matrices, matrices) ==
+            NaiveConvolve(matrices, matrices_copy));
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    std::vector<std::complex<double>> values(300);
+    for (auto& value : values) {
+        value = {dist(gen), dist(gen)};
+    }
+    auto values_copy = values;
+    auto square = SingleVariable::Convolve(values, values);
+    auto expected = NaiveConvolve(values, values_copy);
+    for (size_t i = 0; i < square.size(); ++i) {
+        REQUIRE(std::abs(square[i] - expected[i]) < 1e-9);
+    }
+}
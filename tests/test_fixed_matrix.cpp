@@ -0,0 +1,58 @@
+#include <catch.hpp>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+#include "../include/fixed_matrix.h"
+#include "../include/matrix.h"
+#include "../include/polynomial.h"
+
+TEST_CASE("Compile time operations") {
+    constexpr FixedMatrix<int, 2, 3> a = {{1, 2, 3}, {4, 5, 6}};
+    constexpr FixedMatrix<int, 3, 2> b = {{1, 2}, {3, 4}, {5, 6}};
+    constexpr auto product = a * b;
+    static_assert(product == FixedMatrix<int, 2>{{22, 28}, {49, 64}});
+    static_assert(Transpose(a) == FixedMatrix<int, 3, 2>{{1, 4}, {2, 5}, {3, 6}});
+    static_assert(a + a == 2 * a);
+    static_assert(a - a == FixedMatrix<int, 2, 3>());
+    static_assert(-a == a * -1);
+    static_assert(FixedMatrix<int, 3>(1) * b == b);
+    static_assert(sizeof(FixedMatrix<double, 4>) == 16 * sizeof(double));
+}
+
+TEST_CASE("Fixed matrix constants") {
+    FixedMatrix<int, 3> m = {{1, 0, 2}, {3, 5, 0}, {1, 1, 8}};
+    REQUIRE(GetZero(m) == FixedMatrix<int, 3>());
+    REQUIRE(GetOne(m) * m == m);
+    REQUIRE(GetConst(FixedMatrix<int, 2, 3>(), 7)(1, 2) == 7);
+    REQUIRE_THROWS_AS((FixedMatrix<int, 2>{{1, 2}, {3}}), std::runtime_error);
+
+    std::stringstream ss;
+    ss << FixedMatrix<int, 2>{{1, 2}, {3, 4}};
+    REQUIRE(ss.str() == "1 2 \n3 4 \n");
+}
+
+TEST_CASE("Fixed matrix polynomials") {
+    FixedMatrix<int64_t, 3> m = {{1, 0, 2}, {3, 5, 0}, {1, 1, 8}};
+    SingleVariable::Polynomial<int64_t> xi = {{-1, 3}, {14, 2}, {-51, 1}, {36, 0}};
+    REQUIRE(xi(m) == FixedMatrix<int64_t, 3>());
+
+    // x^40 wraps around, which is defined for unsigned elements only
+    Matrix<uint64_t> dynamic = {{1, 0, 2}, {3, 5, 0}, {1, 1, 8}};
+    SingleVariable::Polynomial<uint64_t> p = {{3, 40}, {2, 17}, {1, 1}, {5, 0}};
+    Matrix<uint64_t> expected = p(dynamic);
+    FixedMatrix<uint64_t, 3> value = p(FixedMatrix<uint64_t, 3>{{1, 0, 2}, {3, 5, 0}, {1, 1, 8}});
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            REQUIRE(value(i, j) == expected(i, j));
+        }
+    }
+
+    using Coef = FixedMatrix<int, 2>;
+    Coef a = {{1, 2}, {0, 1}};
+    Coef b = {{0, 1}, {1, 0}};
+    Coef x = {{2, 1}, {1, 3}};
+    SingleVariable::Polynomial<Coef> q = {{a, 2}, {b, 0}};
+    REQUIRE(q(x) == a * x * x + b);
+    REQUIRE((q * q)(x) == a * a * x * x * x * x + (a * b + b * a) * x * x + b * b);
+}
@@ -1,6 +1,11 @@
 #include <catch.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "../include/matrix.h"
@@ -42,6 +47,24 @@ TEST_CASE("Constructors") {
     }
 }
 
+TEST_CASE("Layout") {
+    Matrix<double> a(5, 3);
+    REQUIRE(a.Stride() >= a.Columns());
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        REQUIRE(reinterpret_cast<uintptr_t>(a.Row(i)) % kCacheLineSize == 0);
+        REQUIRE(&a(i, 0) == a.Row(i));
+    }
+    REQUIRE(&a(1, 2) - &a(0, 2) == static_cast<ptrdiff_t>(a.Stride()));
+
+    Matrix<int> b = {{1, 2, 3}, {4, 5, 6}};
+    Matrix<int> c = b;
+    c(1, 1) = 0;
+    REQUIRE(b(1, 1) == 5);
+    REQUIRE_FALSE(b == c);
+    REQUIRE(Matrix<int>(0, 4).Shape() == std::pair<size_t, size_t>{0, 0});
+    REQUIRE_THROWS_AS(Matrix<int>({{1, 2}, {3}}), std::runtime_error);
+}
+
 TEST_CASE("Constness") {
     {
         Matrix<int> a({{1, 2}, {3, 4}});
@@ -120,6 +143,144 @@ TEST_CASE("Multipling") {
     }
 }
 
+template <typename T>
+Matrix<T> FilledMatrix(size_t rows, size_t cols, int seed) {
+    Matrix<T> res(rows, cols);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            res(i, j) = static_cast<T>(static_cast<int>((i * 31 + j * 17 + seed) % 19) - 9);
+        }
+    }
+    return res;
+}
+
+template <typename T>
+Matrix<T> NaiveProduct(const Matrix<T>& lhs, const Matrix<T>& rhs) {
+    Matrix<T> res(lhs.Rows(), rhs.Columns());
+    for (size_t i = 0; i < lhs.Rows(); ++i) {
+        for (size_t j = 0; j < rhs.Columns(); ++j) {
+            for (size_t k = 0; k < lhs.Columns(); ++k) {
+                res(i, j) += lhs(i, k) * rhs(k, j);
+            }
+        }
+    }
+    return res;
+}
+
+TEST_CASE("Blocked multiplying") {
+    auto left = FilledMatrix<int64_t>(137, 300, 1);
+    auto right = FilledMatrix<int64_t>(300, 70, 2);
+    REQUIRE(left * right == NaiveProduct(left, right));
+
+    auto wide = FilledMatrix<double>(33, 2100, 3);
+    auto tall = FilledMatrix<double>(2100, 5, 4);
+    REQUIRE(wide * tall == NaiveProduct(wide, tall));
+    REQUIRE(Transpose(tall) * Transpose(wide) == Transpose(NaiveProduct(wide, tall)));
+
+    Matrix<int64_t> res(2, 2);
+    MultiplyInto(left, right, res);
+    REQUIRE(res == left * right);
+    MultiplyInto(left, right, res);
+    REQUIRE(res == left * right);
+}
+
+TEST_CASE("Vectorized multiplying") {
+    auto left_double = FilledMatrix<double>(131, 260, 5);
+    auto right_double = FilledMatrix<double>(260, 45, 6);
+    REQUIRE(left_double * right_double == NaiveProduct(left_double, right_double));
+
+    auto left_float = FilledMatrix<float>(70, 97, 7);
+    auto right_float = FilledMatrix<float>(97, 83, 8);
+    REQUIRE(left_float * right_float == NaiveProduct(left_float, right_float));
+
+    auto left_int = FilledMatrix<int32_t>(64, 300, 9);
+    auto right_int = FilledMatrix<int32_t>(300, 50, 10);
+    REQUIRE(left_int * right_int == NaiveProduct(left_int, right_int));
+    Matrix<int32_t> big(40, 40);
+    for (size_t i = 0; i < 40; ++i) {
+        for (size_t j = 0; j < 40; ++j) {
+            big(i, j) = 1 << 20;
+        }
+    }
+    // Wraps modulo 2^32 like uint32_t arithmetic
+    REQUIRE((big * big)(3, 5) == 0);
+
+    // Small products skip the kernels and wrap the same way
+    Matrix<int64_t> small = {{INT64_MAX, 2}, {-3, INT64_MIN}};
+    Matrix<uint64_t> small_unsigned(2, 2);
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            small_unsigned(i, j) = static_cast<uint64_t>(small(i, j));
+        }
+    }
+    auto product = small * small;
+    auto product_unsigned = small_unsigned * small_unsigned;
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            REQUIRE(product(i, j) == static_cast<int64_t>(product_unsigned(i, j)));
+        }
+    }
+}
+
+TEST_CASE("Parallel multiplying") {
+    ThreadPool::SetGlobalThreads(4);
+    auto left = FilledMatrix<double>(300, 200, 11);
+    auto right = FilledMatrix<double>(200, 700, 12);
+    auto expected = Multiply(left, right, 1);
+    REQUIRE(expected == NaiveProduct(left, right));
+    REQUIRE(Multiply(left, right, 3) == expected);
+    REQUIRE(left * right == expected);
+
+    auto left_int = FilledMatrix<int64_t>(150, 150, 13);
+    Matrix<int64_t> res(150, 150);
+    MultiplyInto(left_int, left_int, res, 2);
+    REQUIRE(res == NaiveProduct(left_int, left_int));
+    ThreadPool::SetGlobalThreads(1);
+}
+
+TEST_CASE("Strassen multiplying") {
+    for (size_t n : {512, 517}) {
+        auto left = FilledMatrix<int64_t>(n, n, 14);
+        auto right = FilledMatrix<int64_t>(n, n, 15);
+        Matrix<int64_t> expected(n);
+        Gemm<int64_t>(left, right, expected.Row(0), expected.Stride());
+        REQUIRE(left * right == expected);
+    }
+
+    size_t n = kStrassenThreshold + 3;
+    auto left = FilledMatrix<int32_t>(n, n, 16);
+    Matrix<int32_t> expected(n);
+    Gemm<int32_t>(left, left, expected.Row(0), expected.Stride());
+    Matrix<int32_t> res(1, 1);
+    MultiplyInto(left, left, res);
+    REQUIRE(res == expected);
+}
+
+TEST_CASE("Narrow integer multiplying") {
+    // int16_t is not reinterpreted as uint16_t, which would promote to int and overflow
+    for (size_t n : {size_t{3}, size_t{40}, kStrassenThreshold + 3}) {
+        Matrix<int16_t> left(n);
+        Matrix<int16_t> right(n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                left(i, j) = static_cast<int16_t>((i + j) % 2 == 0 ? 32767 - j : -1 - i);
+                right(i, j) = static_cast<int16_t>(i % 3 == 0 ? -1 - j : 32767 - i * j);
+            }
+        }
+        Matrix<int16_t> res(1, 1);
+        MultiplyInto(left, right, res);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                int64_t expected = 0;
+                for (size_t k = 0; k < n; ++k) {
+                    expected += int64_t{left(i, k)} * right(k, j);
+                }
+                REQUIRE(res(i, j) == static_cast<int16_t>(expected));
+            }
+        }
+    }
+}
+
 TEST_CASE("Mixed ops") {
     Matrix<uint64_t> left{{1, 1}, {1, 1}};
     const auto inf = std::numeric_limits<uint64_t>::max();
@@ -143,3 +304,260 @@ TEST_CASE("Exceptions") {
     Matrix<int> fourth(5, 7);
     REQUIRE_THROWS_AS(Matrix<int>(first * second * third * fourth), std::runtime_error);
 }
+
+TEST_CASE("Views") {
+    Matrix<int> a = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+    auto block = a.Block(1, 1, 2, 2);
+    REQUIRE(block.Shape() == std::pair<size_t, size_t>{2, 2});
+    REQUIRE(block == Matrix<int>{{5, 6}, {8, 9}});
+    REQUIRE(TransposedView(a) == Transpose(a));
+    REQUIRE(TransposedView(a).Block(0, 1, 2, 1) == Matrix<int>{{4}, {5}});
+    REQUIRE(Matrix<int>(block.Transposed()) == Matrix<int>{{5, 8}, {6, 9}});
+
+    REQUIRE(block + block == Matrix<int>{{10, 12}, {16, 18}});
+    REQUIRE(a.Block(0, 0, 2, 2) - block == Matrix<int>{{-4, -4}, {-4, -4}});
+    REQUIRE(a * TransposedView(a) == a * Transpose(a));
+    REQUIRE(TransposedView(a) * a == Transpose(a) * a);
+    REQUIRE(a.Block(0, 0, 2, 3) * a.Block(0, 1, 3, 2) == Matrix<int>{{36, 42}, {81, 96}});
+    REQUIRE_THROWS_AS(Matrix<int>(block * a), std::runtime_error);
+    REQUIRE_THROWS_AS(a.Block(2, 2, 2, 2), std::runtime_error);
+
+    block.Assign(Matrix<int>{{0, 0}, {0, 0}});
+    block += Identity<int>(2);
+    block *= 3;
+    REQUIRE(a == Matrix<int>{{1, 2, 3}, {4, 3, 0}, {7, 0, 3}});
+
+    std::stringstream ss;
+    ss << a.Block(0, 0, 1, 2) << TransposedView(Matrix<int>{{1, 2}});
+    REQUIRE(ss.str() == "1 2 \n1 \n2 \n");
+
+    auto big = FilledMatrix<double>(200, 150, 17);
+    auto other = FilledMatrix<double>(200, 90, 18);
+    REQUIRE(TransposedView(big) * other == NaiveProduct(Transpose(big), other));
+    REQUIRE(TransposedView(other) * big.Block(0, 10, 200, 100) ==
+            NaiveProduct(Transpose(other), Matrix<double>(big.Block(0, 10, 200, 100))));
+}
+
+TEST_CASE("Transpose in place") {
+    for (size_t n : {1, 5, 32, 33, 100}) {
+        auto a = FilledMatrix<int>(n, n, 19);
+        auto expected = TransposedView(a);
+        Matrix<int> copy = a;
+        TransposeInPlace(copy);
+        REQUIRE(copy == expected);
+    }
+    for (auto [rows, cols] : {std::pair<size_t, size_t>{1, 7}, {3, 5}, {40, 9}, {17, 130}}) {
+        auto a = FilledMatrix<double>(rows, cols, 20);
+        Matrix<double> copy = a;
+        TransposeInPlace(copy);
+        REQUIRE(copy.Shape() == std::pair<size_t, size_t>{cols, rows});
+        REQUIRE(copy == TransposedView(a));
+        REQUIRE(copy == Transpose(a));
+        TransposeInPlace(copy);
+        REQUIRE(copy == a);
+        REQUIRE(copy * Transpose(a) == a * Transpose(a));
+    }
+    auto wide = FilledMatrix<int64_t>(70, 300, 21);
+    REQUIRE(Transpose(wide) == TransposedView(wide));
+
+    for (auto [rows, cols] : {std::pair<size_t, size_t>{4, 0}, {0, 4}, {0, 0}}) {
+        Matrix<int> empty(rows, cols);
+        Matrix<int> copy = empty;
+        TransposeInPlace(copy);
+        REQUIRE(copy.Shape() == Transpose(empty).Shape());
+        REQUIRE(copy == Transpose(empty));
+    }
+
+    // Rows of non-arithmetic elements are unpadded
+    for (auto [rows, cols] : {std::pair<size_t, size_t>{2, 3}, {3, 2}, {4, 7}}) {
+        Matrix<std::vector<int>> vectors(rows, cols);
+        for (size_t i = 0; i < rows; ++i) {
+            for (size_t j = 0; j < cols; ++j) {
+                vectors(i, j) = {static_cast<int>(i), static_cast<int>(j), 1};
+            }
+        }
+        Matrix<std::vector<int>> copy = vectors;
+        TransposeInPlace(copy);
+        REQUIRE((copy == Transpose(vectors)));
+        TransposeInPlace(copy);
+        REQUIRE((copy == vectors));
+    }
+}
+
+TEST_CASE("Temporary operands") {
+    auto a = FilledMatrix<int>(5, 7, 22);
+    auto b = FilledMatrix<int>(5, 7, 23);
+    auto c = FilledMatrix<int>(5, 7, 24);
+    Matrix<int> expected(5, 7);
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 7; ++j) {
+            expected(i, j) = a(i, j) + b(i, j) - c(i, j);
+        }
+    }
+    REQUIRE(a + b - c == expected);
+    REQUIRE(a - (c - b) == expected);
+    REQUIRE((a - c) + b == expected);
+    REQUIRE(b + (a - c) == expected);
+    REQUIRE((a + b) - (c + Matrix<int>(5, 7)) == expected);
+    REQUIRE((a + b) * 3 == 3 * (a + b));
+    REQUIRE(2 * (a + b) == a * 2 + b * 2);
+
+    // The temporary's buffer becomes the result
+    Matrix<int> sum = a + b;
+    const int* data = sum.Row(0);
+    Matrix<int> result = std::move(sum) - c;
+    REQUIRE(result.Row(0) == data);
+    REQUIRE(result == expected);
+    result = a - std::move(result);
+    REQUIRE(result.Row(0) == data);
+    REQUIRE(result == c - b);
+}
+
+TEST_CASE("Multiply assign") {
+    auto a = FilledMatrix<int64_t>(30, 30, 25);
+    auto b = FilledMatrix<int64_t>(30, 30, 26);
+    Matrix<int64_t> power = Identity<int64_t>(30);
+    Matrix<int64_t> expected = Identity<int64_t>(30);
+    for (int i = 0; i < 4; ++i) {
+        power *= a;
+        expected = expected * a;
+    }
+    REQUIRE(power == expected);
+    power *= power;
+    REQUIRE(power == expected * expected);
+
+    Matrix<int64_t> rect = FilledMatrix<int64_t>(4, 30, 27);
+    rect *= b;
+    REQUIRE(rect == NaiveProduct(FilledMatrix<int64_t>(4, 30, 27), b));
+    rect *= Matrix<int64_t>(30, 2);
+    REQUIRE(rect.Shape() == std::pair<size_t, size_t>{4, 2});
+
+    Matrix<int64_t>::ReleaseProductScratch();
+    power = a;
+    power *= b;
+    REQUIRE(power == NaiveProduct(a, b));
+}
+
+TEST_CASE("Lazy expressions") {
+    auto a = FilledMatrix<int64_t>(40, 40, 28);
+    auto b = FilledMatrix<int64_t>(40, 40, 29);
+    auto c = FilledMatrix<int64_t>(40, 40, 30);
+    auto wide = FilledMatrix<int64_t>(40, 70, 31);
+
+    Matrix<int64_t> r = Lazy(a) + Lazy(b) * int64_t{3} - c;
+    REQUIRE(r == a + b * int64_t{3} - c);
+    r = int64_t{2} * (Lazy(a) - b) + c;
+    REQUIRE(r == 2 * (a - b) + c);
+    r = Lazy(a) * b + c;
+    REQUIRE(r == NaiveProduct(a, b) + c);
+    r = c + Lazy(a) * b + Lazy(b) * a - a;
+    REQUIRE(r == c + NaiveProduct(a, b) + NaiveProduct(b, a) - a);
+    r = Lazy(a) * wide;
+    REQUIRE(r == NaiveProduct(a, wide));
+    r = Lazy(a) * (Lazy(b) + c);
+    REQUIRE(r == NaiveProduct(a, b + c));
+    r = Lazy(a.Block(0, 0, 40, 10)) * Transpose(wide).Block(0, 0, 10, 40) + a;
+    REQUIRE(r == NaiveProduct(Matrix<int64_t>(a.Block(0, 0, 40, 10)),
+                              Matrix<int64_t>(Transpose(wide).Block(0, 0, 10, 40))) +
+                     a);
+
+    // Elementwise updates of the destination reuse its buffer
+    Matrix<int64_t> acc = a;
+    const int64_t* data = acc.Row(0);
+    acc = Lazy(acc) + b - c;
+    REQUIRE(acc.Row(0) == data);
+    REQUIRE(acc == a + b - c);
+    acc += Lazy(b) * int64_t{2};
+    REQUIRE(acc.Row(0) == data);
+    REQUIRE(acc == a + b * int64_t{3} - c);
+    acc -= Lazy(b) * int64_t{3};
+    REQUIRE(acc == a - c);
+
+    // Overlapping operands go through a temporary unless NoAlias is asked for
+    acc = a;
+    acc = Lazy(acc) * b + acc;
+    REQUIRE(acc == NaiveProduct(a, b) + a);
+    acc = a;
+    acc += Lazy(acc) * acc;
+    REQUIRE(acc == a + NaiveProduct(a, a));
+    acc = a;
+    acc = Lazy(TransposedView(acc)) + b;
+    REQUIRE(acc == Transpose(a) + b);
+    acc = Lazy(acc.Block(0, 0, 20, 20)) + b.Block(20, 20, 20, 20);
+    REQUIRE(acc == Matrix<int64_t>(Transpose(a) + b).Block(0, 0, 20, 20) +
+                       b.Block(20, 20, 20, 20));
+
+    Matrix<int64_t> out(1, 1);
+    NoAlias(out) = Lazy(a) * b;
+    REQUIRE(out == NaiveProduct(a, b));
+    data = out.Row(0);
+    NoAlias(out) += Lazy(b) * a + c;
+    REQUIRE(out.Row(0) == data);
+    REQUIRE(out == NaiveProduct(a, b) + NaiveProduct(b, a) + c);
+
+    REQUIRE_THROWS_AS(Lazy(a) + wide, std::runtime_error);
+    REQUIRE_THROWS_AS(Lazy(wide) * a, std::runtime_error);
+    REQUIRE_THROWS_AS(NoAlias(out) += Lazy(wide), std::runtime_error);
+
+    auto x = FilledMatrix<double>(13, 29, 32);
+    auto y = FilledMatrix<double>(13, 29, 33);
+    Matrix<double> z = 0.5 * Lazy(x) - Lazy(y) * 2.0 + x;
+    REQUIRE(EqualMatrix(z, x * 0.5 - y * 2.0 + x));
+}
+
+TEST_CASE("Ring traits") {
+    static_assert(!std::is_polymorphic_v<Matrix<int>>);
+    Matrix<int> m = Identity<int>(3) * 2;
+    REQUIRE(GetOne(m) == Identity<int>(3));
+    REQUIRE(GetZero(m) == Matrix<int>(3, 3));
+    REQUIRE(IsZero(Matrix<int>(2, 5)));
+    REQUIRE_FALSE(IsZero(m));
+    REQUIRE(Matrix<int>::Constant(2, 3, 7) == Matrix<int>({{7, 7, 7}, {7, 7, 7}}));
+}
+
+TEST_CASE("Scaled identity") {
+    Matrix<int> m = {{1, 2}, {3, 4}};
+    auto one = GetLazyOne(m);
+    REQUIRE(Matrix<int>(one) == Identity<int>(2));
+    REQUIRE(Matrix<int>(3 * one * 2) == Identity<int>(2) * 6);
+    REQUIRE(m + 5 * one == Matrix<int>{{6, 2}, {3, 9}});
+    REQUIRE(5 * one + m == Matrix<int>{{6, 2}, {3, 9}});
+    REQUIRE(m - one == Matrix<int>{{0, 2}, {3, 3}});
+    REQUIRE(m * (2 * one) == m * 2);
+    REQUIRE((2 * one) * m == m * 2);
+    REQUIRE(Matrix<int>(m) * one == m);
+
+    Matrix<int> acc(2, 3);
+    acc += GetLazyOne(acc) * 7;
+    REQUIRE(acc == Matrix<int>{{7, 0, 0}, {0, 7, 0}});
+    REQUIRE_THROWS_AS(m += GetLazyOne(acc), std::runtime_error);
+    REQUIRE_THROWS_AS(acc * GetLazyOne(acc), std::runtime_error);
+
+    // Zeros stay symbolic until a matrix is needed, whatever the shape
+    auto zero = GetLazyZero(acc);
+    static_assert(std::is_same_v<decltype(zero), ScaledIdentity<int>>);
+    REQUIRE(Matrix<int>(zero) == Matrix<int>(2, 3));
+    REQUIRE(Matrix<int>(2, 3) == zero);
+    REQUIRE_FALSE(acc == zero);
+    REQUIRE(acc + zero == acc);
+    REQUIRE(zero * Matrix<int>(3, 4) == Matrix<int>(2, 4));
+    REQUIRE(Matrix<int>(4, 2) * zero == Matrix<int>(4, 3));
+    REQUIRE_THROWS_AS(zero * acc, std::runtime_error);
+    static_assert(std::is_same_v<decltype(GetZero(m)), Matrix<int>>);
+    Matrix<int> from_zero = GetLazyZero(m);
+    REQUIRE(from_zero == Matrix<int>(2, 2));
+}
+
+TEST_CASE("Squares") {
+    size_t n = 300;
+    auto a = FilledMatrix<int64_t>(n, n, 5);
+    auto symmetric = a + Transpose(a);
+    REQUIRE(IsSymmetric<int64_t>(symmetric));
+    REQUIRE_FALSE(IsSymmetric<int64_t>(a));
+    REQUIRE(Square(symmetric) == NaiveProduct(symmetric, symmetric));
+    REQUIRE(Square(a) == NaiveProduct(a, a));
+
+    auto x = FilledMatrix<double>(n, n, 6);
+    Matrix<double> y = x + Transpose(x);
+    REQUIRE(EqualMatrix(BinaryPow()(y, 3), y * Matrix<double>(y) * Matrix<double>(y)));
+}
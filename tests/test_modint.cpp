@@ -0,0 +1,106 @@
+#include <catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/convolution.h"
+#include "../include/matrix.h"
+#include "../include/modint.h"
+#include "../include/polynomial.h"
+
+TEST_CASE("Modular arithmetic") {
+    using Mod = ModInt<998244353>;
+    REQUIRE(Mod(-1).Value() == 998244352);
+    REQUIRE(Mod(998244353) == Mod(0));
+    REQUIRE(Mod(998244352) + Mod(5) == Mod(4));
+    REQUIRE(Mod(3) - Mod(5) == Mod(-2));
+    REQUIRE(Mod(123456789) * Mod(987654321) ==
+            Mod(static_cast<int64_t>(123456789LL * 987654321LL % 998244353)));
+    REQUIRE(Mod(7) / Mod(7) == Mod(1));
+    REQUIRE(Mod(3).Pow(998244352) == Mod(1));
+    REQUIRE(-Mod(1) == Mod(998244352));
+    REQUIRE(GetOne(Mod(17)) == Mod(1));
+
+    static_assert(IsPrime(998244353));
+    static_assert(!IsPrime(1000000005));
+    static_assert(PrimitiveRoot(998244353) == 3);
+    static_assert(PrimitiveRoot(7) == 3);
+}
+
+TEST_CASE("Modular coefficients") {
+    using Mod = ModInt<7>;
+    SingleVariable::Polynomial<Mod> p = {{Mod(1), 1}, {Mod(1), 0}};  // x + 1
+    auto p7 = DefaultPow()(p, 7);
+    p7.Reduce();
+    REQUIRE(p7 == SingleVariable::Polynomial<Mod>{{Mod(1), 7}, {Mod(1), 0}});
+    REQUIRE(p(Mod(6)) == Mod(0));
+
+    Matrix<Mod> m = {{Mod(1), Mod(2)}, {Mod(3), Mod(4)}};
+    REQUIRE(m * m == Matrix<Mod>{{Mod(0), Mod(3)}, {Mod(1), Mod(1)}});
+}
+
+TEST_CASE("Dynamic modulus") {
+    DynModInt::SetModulus(1000000007);
+    using Mod = DynModInt;
+    REQUIRE(Mod(-1).Value() == 1000000006);
+    REQUIRE(Mod(1000000006) + Mod(5) == Mod(4));
+    REQUIRE(Mod(3) - Mod(5) == Mod(-2));
+    REQUIRE(Mod(123456789) * Mod(987654321) ==
+            Mod(static_cast<int64_t>(123456789LL * 987654321LL % 1000000007)));
+    REQUIRE(Mod(7) / Mod(7) == Mod(1));
+    REQUIRE(Mod(3).Pow(1000000006) == Mod(1));
+    REQUIRE(GetOne(Mod(17)) == Mod(1));
+
+    DynModInt::SetModulus(12);
+    REQUIRE(Mod(5).Inverse() == Mod(5));
+    REQUIRE_THROWS_AS(Mod(4).Inverse(), std::runtime_error);
+    REQUIRE_THROWS_AS(DynModInt::SetModulus(1), std::runtime_error);
+    REQUIRE_THROWS_AS(DynModInt::SetModulus(1u << 31), std::runtime_error);
+}
+
+// Products long enough for the blocked kernel, which sums them with lazy reduction
+template <typename Mod>
+void CheckLazyProducts(std::mt19937& gen) {
+    size_t n = 70;
+    size_t depth = 300;
+    Matrix<Mod> a(n, depth);
+    Matrix<Mod> b(depth, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < depth; ++j) {
+            a(i, j) = Mod(static_cast<int64_t>(gen()));
+            b(j, i) = Mod(-static_cast<int64_t>(gen()));
+        }
+    }
+    Matrix<Mod> expected(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t k = 0; k < depth; ++k) {
+                expected(i, j) += a(i, k) * b(k, j);
+            }
+        }
+    }
+    REQUIRE(a * b == expected);
+
+    std::vector<Mod> lhs(a.Row(0), a.Row(0) + depth);
+    std::vector<Mod> rhs(b.Row(0), b.Row(0) + n);
+    std::vector<Mod> naive(depth + n - 1);
+    for (size_t i = 0; i < depth; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            naive[i + j] += lhs[i] * rhs[j];
+        }
+    }
+    REQUIRE(SingleVariable::Convolve(lhs, rhs) == naive);
+}
+
+TEST_CASE("Lazy reduction") {
+    std::mt19937 gen(29);
+    CheckLazyProducts<ModInt<1000000007>>(gen);
+    CheckLazyProducts<ModInt<2147483647>>(gen);
+    CheckLazyProducts<ModInt<(1u << 30)>>(gen);
+    DynModInt::SetModulus(2147483629);
+    CheckLazyProducts<DynModInt>(gen);
+    DynModInt::SetModulus(3);
+    CheckLazyProducts<DynModInt>(gen);
+}
@@ -1,6 +1,10 @@
 #include <catch.hpp>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <set>
+#include <stdexcept>
+#include <vector>
 
 #include "../include/matrix.h"
 #include "../include/monomial.h"
@@ -51,4 +55,91 @@ TEST_CASE("Substitution") {
             SingleVariable::Monomial<double>{220, 1},   SingleVariable::Monomial<double>{550, 0}};
         REQUIRE(b(poly).GetMonomials() == expected);
     }
-}
\ No newline at end of file
+}
+
+TEMPLATE_TEST_CASE("Pow functions", "", IterativePow, SlidingWindowPow, TablePow) {
+    TestType pow;
+    for (size_t exponent : {0, 1, 2, 3, 7, 8, 255, 256, 1000, 65537, 1234567}) {
+        REQUIRE(pow(uint64_t{3}, exponent) == BinaryPow()(uint64_t{3}, exponent));
+        REQUIRE(pow(uint64_t{5}, exponent) == BinaryPow()(uint64_t{5}, exponent));
+    }
+    REQUIRE(pow(uint64_t{3}, ~size_t{0}) == BinaryPow()(uint64_t{3}, ~size_t{0}));
+
+    auto matrix = Matrix<int64_t>{{1, 1, 0}, {1, 0, 1}, {0, 1, -1}};
+    for (size_t exponent = 0; exponent <= 40; ++exponent) {
+        REQUIRE(pow(matrix, exponent) == BinaryPow()(matrix, exponent));
+    }
+
+    SingleVariable::Monomial<int, TestType> a{2, 4};
+    REQUIRE(a(3) == 162);
+    REQUIRE(a(Matrix<int>{{2, 1, 5}, {3, 3, 7}, {8, 0, 4}}) ==
+            Matrix<int>{{8680, 1182, 8262}, {14522, 2022, 13958}, {11024, 1568, 10848}});
+
+    SingleVariable::Polynomial<int, TestType> poly{{10, 0}, {5, 3}, {2, 1}};
+    REQUIRE(pow(poly, 3) == DefaultPow()(poly, 3));
+}
+
+TEST_CASE("Pow base cases") {
+    // The first power is the object itself, without a product with the identity, so
+    // shapes without one work too
+    Matrix<int> rect = {{1, 2, 3}, {4, 5, 6}};
+    REQUIRE(DefaultPow()(rect, 1) == rect);
+    REQUIRE(BinaryPow()(rect, 1) == rect);
+    REQUIRE(IterativePow()(rect, 1) == rect);
+    REQUIRE(SlidingWindowPow()(rect, 1) == rect);
+    REQUIRE(TablePow()(rect, 1) == rect);
+    REQUIRE_THROWS_AS(BinaryPow()(rect, 2), std::runtime_error);
+    REQUIRE(DefaultPow()(Matrix<int>{{2, 1}, {0, 3}}, 0) == Identity<int>(2));
+    REQUIRE(BinaryPow()(Matrix<int>{{2, 1}, {0, 3}}, 0) == Identity<int>(2));
+}
+
+// Counts its products, to see how many multiplications an evaluation takes
+struct CountedInt {
+    uint64_t value;
+    static inline size_t products = 0;
+
+    friend CountedInt operator*(const CountedInt& lhs, const CountedInt& rhs) {
+        ++products;
+        return {lhs.value * rhs.value};
+    }
+
+    CountedInt& operator*=(const CountedInt& rhs) {
+        return *this = *this * rhs;
+    }
+
+    bool operator==(const CountedInt&) const = default;
+};
+
+TEST_CASE("Table pow shared by monomials") {
+    std::vector<SingleVariable::Monomial<CountedInt, TablePow>> monoms = {
+        {{2}, 40}, {{3}, 33}, {{5}, 48}};
+    CountedInt point{3};
+
+    // x^40 squares the point five times; x^33 and x^48 reuse those squares
+    TablePow pow;
+    CountedInt::products = 0;
+    for (auto& monom : monoms) {
+        REQUIRE(monom(point, pow).value ==
+                monom.GetCoef().value * BinaryPow()(uint64_t{3}, monom.GetDegree()));
+    }
+    REQUIRE(CountedInt::products == 7 + 2 + 2);
+
+    CountedInt::products = 0;
+    for (auto& monom : monoms) {
+        monom(point);
+    }
+    REQUIRE(CountedInt::products == 3 * 7);
+}
+
+TEST_CASE("Table pow keeps the squares of the last base") {
+    TablePow pow;
+    auto matrix = Matrix<int64_t>{{1, 1, 0}, {1, 0, 1}, {0, 1, -1}};
+    auto other = Matrix<int64_t>{{2, 0, 1}, {0, 1, 0}, {1, 0, 1}};
+    for (size_t exponent : {40, 3, 17, 0, 32}) {
+        REQUIRE(pow(matrix, exponent) == BinaryPow()(matrix, exponent));
+        REQUIRE(pow(other, exponent) == BinaryPow()(other, exponent));
+        REQUIRE(pow(uint64_t{3}, exponent) == BinaryPow()(uint64_t{3}, exponent));
+    }
+    pow.Clear();
+    REQUIRE(pow(matrix, 5) == BinaryPow()(matrix, 5));
+}
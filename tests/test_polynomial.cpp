@@ -1,8 +1,14 @@
 #include <catch.hpp>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <set>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include "../include/matrix.h"
 #include "../include/monomial.h"
@@ -234,4 +240,382 @@ TEST_CASE("Reduce") {
     a -= a;
     a.Reduce();
     REQUIRE(a.GetMonomials() == std::set<SingleVariable::Monomial<int>>{});
-}
\ No newline at end of file
+}
+
+TEST_CASE("Dense storage") {
+    using Dense = SingleVariable::Polynomial<int, DefaultPow, SingleVariable::DenseStorage>;
+    Dense p = {{1, 1}, {2, 0}};  // x + 2
+    Dense p2 = {{1, 2}, {4, 1}, {4, 0}};
+    Dense p3 = {{1, 3}, {6, 2}, {12, 1}, {8, 0}};
+    REQUIRE(p * p2 == p3);
+    REQUIRE(DefaultPow()(p, 3) == p3);
+    REQUIRE(p3(1) == 27);
+    REQUIRE(p3(Identity<int>(2)) == 27 * Identity<int>(2));
+
+    Dense a = {{3, 4}, {1, 2}};
+    REQUIRE(a.GetMonomials() ==
+            std::set<SingleVariable::Monomial<int>>{SingleVariable::Monomial<int>{3, 4},
+                                                    SingleVariable::Monomial<int>{1, 2}});
+    a += Dense{{-3, 4}};
+    REQUIRE(a == Dense{{1, 2}});
+    a.Reduce();
+    REQUIRE(a == Dense{{1, 2}});
+    REQUIRE((a - a) == Dense{});
+    REQUIRE(0 * a ==
+            SingleVariable::GetZeroPolynomial<int, DefaultPow, SingleVariable::DenseStorage>());
+
+    SingleVariable::Polynomial<int> sparse;
+    Dense dense;
+    for (int i = 0; i < 200; ++i) {
+        sparse += SingleVariable::Monomial<int>(i % 7 - 3, i);
+        dense += SingleVariable::Monomial<int>(i % 7 - 3, i);
+    }
+    auto square = sparse * sparse;
+    square.Reduce();
+    REQUIRE((dense * dense).GetMonomials() == square.GetMonomials());
+    REQUIRE(dense(-1) == sparse(-1));
+}
+
+TEST_CASE("Bulk construction") {
+    std::vector<SingleVariable::Monomial<int>> monoms{{5, 7}, {1, 0}, {2, 3}, {-4, 7}, {3, 0}};
+    SingleVariable::Polynomial<int> p(monoms);
+    REQUIRE(p == SingleVariable::Polynomial<int>{{1, 7}, {2, 3}, {4, 0}});
+
+    std::ostringstream os;
+    os << p - SingleVariable::Polynomial<int>{{3, 3}};
+    REQUIRE(os.str() == "1x^7 - 1x^3 + 4 ");
+
+    SingleVariable::Polynomial<int> q = {{1, 8}, {1, 3}, {1, 1}};
+    p += q;
+    REQUIRE(p == SingleVariable::Polynomial<int>{{1, 8}, {1, 7}, {3, 3}, {1, 1}, {4, 0}});
+}
+
+TEST_CASE("Horner evaluation") {
+    SingleVariable::Polynomial<uint64_t> sparse;
+    SingleVariable::Polynomial<uint64_t, DefaultPow, SingleVariable::DenseStorage> dense;
+    uint64_t point = 1000003;
+    uint64_t expected = 0;
+    uint64_t power = 1;
+    for (uint64_t degree = 0; degree < 3000; ++degree) {
+        uint64_t coef = degree * degree % 17;
+        if (coef != 0) {
+            sparse += SingleVariable::Monomial<uint64_t>(coef, degree);
+            dense += SingleVariable::Monomial<uint64_t>(coef, degree);
+        }
+        expected += coef * power;
+        power *= point;
+    }
+    REQUIRE(sparse(point) == expected);
+    REQUIRE(dense(point) == expected);
+
+    Matrix<int> a = {{1, 2}, {0, 1}};
+    Matrix<int> b = {{0, 1}, {1, 0}};
+    Matrix<int> x = {{2, 1}, {1, 3}};
+    SingleVariable::Polynomial<Matrix<int>> matrix_poly = {{a, 3}, {b, 1}};
+    REQUIRE(matrix_poly(x) == a * x * x * x + b * x);
+}
+
+TEST_CASE("Mixed type evaluation") {
+    // Every term coef * x^degree is narrowed to the point type on its own
+    SingleVariable::Polynomial<double> halves = {{0.5, 1}, {0.5, 0}};
+    REQUIRE(halves(1) == 0);
+    REQUIRE(halves(3) == 1);
+    REQUIRE(halves(2.0) == 1.5);
+    SingleVariable::Polynomial<double, DefaultPow, SingleVariable::DenseStorage> dense = {
+        {1.5, 2}, {0.5, 1}, {0.75, 0}};
+    REQUIRE(dense(3) == 13 + 1);
+    REQUIRE(SingleVariable::Polynomial<double>{}(5) == 0);
+
+    // A matrix point narrows the same way: p(x) is the diagonal of p(x * I)
+    SingleVariable::Polynomial<double> mixed = {{-0.75, 5}, {1.5, 2}, {0.5, 1}, {-2.25, 0}};
+    for (int x = -3; x <= 3; ++x) {
+        Matrix<int> diagonal = mixed(x * Identity<int>(2));
+        REQUIRE(diagonal(0, 0) == mixed(x));
+        REQUIRE(diagonal(1, 1) == mixed(x));
+        REQUIRE(diagonal(0, 1) == 0);
+        REQUIRE(diagonal(1, 0) == 0);
+    }
+    REQUIRE(halves(Identity<int>(2)) == Matrix<int>(2));
+}
+
+TEST_CASE("Sparse evaluation") {
+    auto p = SingleVariable::ParseFromString<uint64_t>(
+        "x + 23721817x^3211234 - 2x + -x^37291 + 37891");
+    uint64_t point = 3;
+    uint64_t expected =
+        23721817 * BinaryPow()(point, 3211234) - point - BinaryPow()(point, 37291) + 37891;
+    REQUIRE(p(point) == expected);
+
+    SingleVariable::Polynomial<int> q = {{1, 1000000}, {-1, 999999}};
+    REQUIRE(q(Identity<int>(3)) == Matrix<int>(3));
+    Matrix<int> nilpotent = {{0, 1}, {0, 0}};
+    REQUIRE(SingleVariable::Polynomial<int>{{5, 100000}, {7, 1}, {2, 0}}(nilpotent) ==
+            Matrix<int>{{2, 7}, {0, 2}});
+}
+
+TEST_CASE("Matrix evaluation") {
+    Matrix<int64_t> x = {{1, 2, 0}, {0, -1, 1}, {1, 0, 1}};
+    SingleVariable::Polynomial<int64_t> p;
+    Matrix<int64_t> expected(3);
+    Matrix<int64_t> power = Identity<int64_t>(3);
+    for (int64_t degree = 0; degree <= 60; ++degree) {
+        int64_t coef = degree % 7 - 3;
+        p += SingleVariable::Monomial<int64_t>(coef, degree);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                expected(i, j) += coef * power(i, j);
+            }
+        }
+        power = power * x;
+    }
+    REQUIRE(p(x) == expected);
+
+    SingleVariable::Polynomial<int64_t, DefaultPow, SingleVariable::DenseStorage> dense;
+    dense += SingleVariable::Monomial<int64_t>(4, 0);
+    dense += SingleVariable::Monomial<int64_t>(-2, 9);
+    dense += SingleVariable::Monomial<int64_t>(1, 16);
+    Matrix<int64_t> x16 = Identity<int64_t>(3);
+    for (int i = 0; i < 16; ++i) {
+        x16 = x16 * x;
+    }
+    Matrix<int64_t> x9 = Identity<int64_t>(3);
+    for (int i = 0; i < 9; ++i) {
+        x9 = x9 * x;
+    }
+    Matrix<int64_t> dense_expected = x16;
+    for (size_t i = 0; i < 3; ++i) {
+        dense_expected(i, i) += 4;
+        for (size_t j = 0; j < 3; ++j) {
+            dense_expected(i, j) -= 2 * x9(i, j);
+        }
+    }
+    REQUIRE(dense(x) == dense_expected);
+
+    // Every product coef * x_ij is narrowed on its own, not the coefficient first
+    Matrix<int> small = {{2, 1, 0}, {0, 3, 1}, {1, 0, 1}};
+    SingleVariable::Polynomial<double> halves;
+    Matrix<int> halves_expected(3);
+    Matrix<int> small_power = Identity<int>(3);
+    for (size_t degree = 0; degree <= 12; ++degree) {
+        double coef = degree % 3 == 0 ? 0.5 : 1.25;
+        halves += SingleVariable::Monomial<double>(coef, degree);
+        halves_expected += coef * small_power;
+        small_power = small_power * small;
+    }
+    REQUIRE(halves(small) == halves_expected);
+    REQUIRE(SingleVariable::Polynomial<double>{{0.5, 1}}(small) == 0.5 * small);
+}
+
+TEST_CASE("Batch evaluation") {
+    SingleVariable::Polynomial<int, DefaultPow, SingleVariable::DenseStorage> dense;
+    for (int i = 0; i < 40; ++i) {
+        dense += SingleVariable::Monomial<int>(i % 5 - 2, i);
+    }
+    SingleVariable::Polynomial<int64_t> sparse = {{3, 100}, {-7, 37}, {1, 36}, {5, 2}};
+    std::vector<double> points_double;
+    std::vector<float> points_float;
+    std::vector<int32_t> points_int32;
+    std::vector<int64_t> points_int64;
+    for (int i = 0; i < 103; ++i) {
+        points_double.push_back(-1.0 + i / 51.0);
+        points_float.push_back(static_cast<float>(points_double.back()));
+        points_int32.push_back(i * 7919 - 300000);
+        points_int64.push_back(static_cast<int64_t>(i) * 1000003 - 17);
+    }
+
+    std::vector<double> out_double(points_double.size());
+    dense.Evaluate(std::span<const double>(points_double), std::span<double>(out_double));
+    for (size_t i = 0; i < points_double.size(); ++i) {
+        REQUIRE(out_double[i] == Approx(dense(points_double[i])));
+    }
+    sparse.Evaluate(std::span<const double>(points_double), std::span<double>(out_double));
+    for (size_t i = 0; i < points_double.size(); ++i) {
+        REQUIRE(out_double[i] == Approx(sparse(points_double[i])));
+    }
+
+    std::vector<float> out_float(points_float.size());
+    dense.Evaluate(std::span<const float>(points_float), std::span<float>(out_float));
+    for (size_t i = 0; i < points_float.size(); ++i) {
+        REQUIRE(out_float[i] == Approx(dense(points_float[i])).epsilon(1e-4).margin(1e-4));
+    }
+    SingleVariable::Polynomial<double> fractions = {
+        {0.1, 9}, {1.0 / 3, 5}, {-2.0 / 7, 4}, {0.7, 1}, {1e-3, 0}};
+    fractions.Evaluate(std::span<const float>(points_float), std::span<float>(out_float));
+    for (size_t i = 0; i < points_float.size(); ++i) {
+        REQUIRE(out_float[i] == Approx(fractions(points_float[i])).epsilon(1e-5).margin(1e-6));
+    }
+
+    std::vector<int32_t> out_int32(points_int32.size());
+    std::vector<int64_t> out_int64(points_int64.size());
+    sparse.Evaluate(std::span<const int32_t>(points_int32), std::span<int32_t>(out_int32));
+    sparse.Evaluate(std::span<const int64_t>(points_int64), std::span<int64_t>(out_int64));
+    for (size_t i = 0; i < points_int32.size(); ++i) {
+        auto expected_32 = static_cast<uint32_t>(sparse(static_cast<uint64_t>(points_int32[i])));
+        REQUIRE(static_cast<uint32_t>(out_int32[i]) == expected_32);
+        auto expected_64 = sparse(static_cast<uint64_t>(points_int64[i]));
+        REQUIRE(static_cast<uint64_t>(out_int64[i]) == expected_64);
+    }
+
+    std::vector<double> widened(points_int32.size());
+    SingleVariable::Polynomial<int>{}.Evaluate(std::span<const int32_t>(points_int32),
+                                               std::span<double>(widened));
+    REQUIRE(widened == std::vector<double>(points_int32.size(), 0.0));
+
+    std::vector<Matrix<int>> matrices{Identity<int>(2), Matrix<int>{{0, 1}, {0, 0}}};
+    std::vector<Matrix<int>> out_matrices(2, Matrix<int>(2));
+    sparse.Evaluate(std::span<const Matrix<int>>(matrices), std::span<Matrix<int>>(out_matrices));
+    REQUIRE(out_matrices[0] == sparse(matrices[0]));
+    REQUIRE(out_matrices[1] == sparse(matrices[1]));
+
+    REQUIRE_THROWS_AS(sparse.Evaluate(std::span<const double>(points_double),
+                                      std::span<double>(out_double).first(3)),
+                      std::runtime_error);
+}
+
+TEST_CASE("Temporary operands") {
+    using Poly = SingleVariable::Polynomial<int>;
+    Poly a{{1, 2}, {3, 4}};
+    Poly b{{-1, 2}, {5, 1}};
+    Poly c{{2, 0}, {1, 4}};
+    Poly d{{7, 3}};
+    REQUIRE(a + b + c + d == Poly{{4, 4}, {7, 3}, {0, 2}, {5, 1}, {2, 0}});
+    REQUIRE(a + (b + c) == (a + b) + c);
+    REQUIRE((a + b) + (c + d) == a + b + c + d);
+    REQUIRE(a - (b + c) == Poly{{2, 2}, {2, 4}, {-5, 1}, {-2, 0}});
+    REQUIRE((a + b) - c == a + b - c);
+    REQUIRE((a + b) - (a + b) == (a + b) * 0);
+    REQUIRE(-(a + b) == -a - b);
+    REQUIRE((a + b) * 3 == 3 * (a + b));
+    REQUIRE((a + b) * 3 == a * 3 + b * 3);
+    REQUIRE((a + 4) - 1 == a + 3);
+    REQUIRE(4 + (a + b) == a + b + 4);
+    REQUIRE((a + b) + SingleVariable::Monomial<int>{2, 1} == a + b + Poly{{2, 1}});
+    REQUIRE(SingleVariable::Monomial<int>{2, 1} + (a + b) == a + b + Poly{{2, 1}});
+    REQUIRE((a + b) * 0.5 == Poly{{0, 2}, {3, 4}, {5, 1}} * 0.5);
+
+    Poly moved = a;
+    Poly sum = std::move(moved) + b;
+    REQUIRE(sum == a + b);
+
+    Matrix<int> m({{1, 2}, {3, 4}});
+    Matrix<int> n({{0, 1}, {1, 0}});
+    SingleVariable::Polynomial<Matrix<int>> p{{m, 1}};
+    REQUIRE(n * (p + p) == SingleVariable::Polynomial<Matrix<int>>{{n * m * 2, 1}});
+    REQUIRE((p + p) * n == SingleVariable::Polynomial<Matrix<int>>{{m * n * 2, 1}});
+}
+
+TEST_CASE("Self assignment operators") {
+    Matrix<int> m({{1, 2}, {3, 4}});
+    Matrix<int> n({{0, 1}, {1, 0}});
+    SingleVariable::Polynomial<Matrix<int>> p{{m, 1}, {n, 3}};
+    auto copy = p;
+    p += p;
+    REQUIRE(p == copy + copy);
+    p -= p;
+    REQUIRE(p == copy - copy);
+
+    SingleVariable::Polynomial<Matrix<int>, DefaultPow, SingleVariable::DenseStorage> dense{
+        {m, 1}, {n, 3}};
+    auto dense_copy = dense;
+    dense += dense;
+    REQUIRE(dense == dense_copy + dense_copy);
+    dense -= dense;
+    REQUIRE(dense == dense_copy - dense_copy);
+}
+
+template <typename Storage>
+void CheckLazyExpressions() {
+    using Poly = SingleVariable::Polynomial<int, DefaultPow, Storage>;
+    using SingleVariable::Lazy;
+    Poly p1{{1, 2}, {3, 4}};
+    Poly p2{{-1, 2}, {5, 1}, {2, 7}};
+    Poly p3{{2, 0}, {1, 4}};
+    Poly p4{{7, 3}};
+
+    Poly r = Lazy(p1) + p2 - 3 * Lazy(p3) + p4;
+    REQUIRE(r == p1 + p2 - 3 * p3 + p4);
+    r = -Lazy(p1) - (Lazy(p2) - p3) * 2;
+    REQUIRE(r == -p1 - (p2 - p3) * 2);
+    r = Lazy(p1) + (p2 + p3);
+    REQUIRE(r == p1 + p2 + p3);
+    r = Lazy(Poly{}) + Poly{};
+    REQUIRE(r == Poly{});
+
+    // The destination may appear in the expression
+    Poly acc = p1;
+    acc = Lazy(acc) + acc * 2;
+    REQUIRE(acc == 3 * p1);
+    acc += Lazy(p2) - p4;
+    REQUIRE(acc == 3 * p1 + p2 - p4);
+    acc -= 2 * Lazy(acc);
+    REQUIRE(acc == -(3 * p1 + p2 - p4));
+
+    // Operands are referenced until the expression is evaluated
+    auto expr = Lazy(p1) + p2;
+    Poly first = expr;
+    Poly old_p1 = p1;
+    p1 += p3;
+    Poly second = expr;
+    REQUIRE(first == old_p1 + p2);
+    REQUIRE(second == p1 + p2);
+
+    std::vector<Poly> polys;
+    std::vector<int> scalars;
+    Poly expected;
+    for (int i = 0; i < 300; ++i) {
+        polys.push_back(Poly{{i % 5 - 2, static_cast<size_t>(i % 17)}, {1, 40 + i % 3}});
+        scalars.push_back(i % 7 - 3);
+        expected += scalars.back() * polys.back();
+    }
+    std::span<const int> scalars_span(scalars);
+    std::span<const Poly> polys_span(polys);
+    REQUIRE(Poly::LinearCombination(scalars_span, polys_span) == expected);
+    REQUIRE_THROWS_AS(Poly::LinearCombination(scalars_span.first(2), polys_span),
+                      std::runtime_error);
+}
+
+TEST_CASE("Lazy expressions") {
+    CheckLazyExpressions<SingleVariable::SparseStorage>();
+    CheckLazyExpressions<SingleVariable::DenseStorage>();
+
+    Matrix<int> m({{1, 2}, {3, 4}});
+    Matrix<int> n({{0, 1}, {1, 0}});
+    using MatrixPoly = SingleVariable::Polynomial<Matrix<int>>;
+    MatrixPoly p{{m, 1}, {n, 0}};
+    MatrixPoly q{{n, 1}};
+    MatrixPoly r = n * SingleVariable::Lazy(p) + SingleVariable::Lazy(q) * m;
+    REQUIRE(r == MatrixPoly{{n * m + n * m, 1}, {n * n, 0}});
+    r = SingleVariable::Lazy(p) * n + p;
+    REQUIRE(r == MatrixPoly{{m * n + m, 1}, {n * n + n, 0}});
+}
+
+TEST_CASE("Squares") {
+    std::vector<SingleVariable::Monomial<int64_t>> monoms;
+    for (int64_t degree = 0; degree < 200; ++degree) {
+        monoms.emplace_back(degree % 13 - 6, degree);
+    }
+    SingleVariable::Polynomial<int64_t> contiguous(monoms);
+    auto copy = contiguous;
+    REQUIRE(contiguous.Square() == contiguous * copy);
+    REQUIRE(contiguous * contiguous == contiguous * copy);
+
+    SingleVariable::Polynomial<int64_t> sparse = {{3, 0}, {-2, 5}, {7, 11}, {1, 1000}};
+    copy = sparse;
+    REQUIRE(sparse.Square() == sparse * copy);
+    REQUIRE(BinaryPow()(sparse, 5) == sparse * copy * copy * copy * copy);
+
+    SingleVariable::Polynomial<int64_t> gapped = {{1, 0}, {2, 3}, {-4, 4}, {5, 6}};
+    copy = gapped;
+    REQUIRE(gapped.Square() == gapped * copy);
+
+    using Dense = SingleVariable::Polynomial<int64_t, DefaultPow, SingleVariable::DenseStorage>;
+    Dense dense(monoms);
+    Dense dense_copy = dense;
+    REQUIRE(dense.Square() == dense * dense_copy);
+
+    Matrix<int> m = {{1, 2}, {3, 4}};
+    Matrix<int> n = {{0, 1}, {1, 0}};
+    SingleVariable::Polynomial<Matrix<int>> matrix_poly = {{m, 1}, {n, 0}};
+    REQUIRE(matrix_poly.Square() ==
+            SingleVariable::Polynomial<Matrix<int>>{{m * m, 2}, {m * n + n * m, 1}, {n * n, 0}});
+}
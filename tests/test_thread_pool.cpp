@@ -0,0 +1,62 @@
+#include <catch.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../include/thread_pool.h"
+
+TEST_CASE("Parallel for") {
+    ThreadPool pool(4);
+    REQUIRE(pool.Size() == 4);
+    std::vector<int> hits(1000);
+    pool.ParallelFor(hits.size(), [&hits](size_t i) { ++hits[i]; });
+    for (int hit : hits) {
+        REQUIRE(hit == 1);
+    }
+
+    std::atomic<size_t> sum = 0;
+    for (size_t count : {0, 1, 3, 4, 5, 17}) {
+        sum = 0;
+        pool.ParallelFor(count, [&sum](size_t i) { sum += i + 1; });
+        REQUIRE(sum == count * (count + 1) / 2);
+    }
+}
+
+TEST_CASE("Thread limit") {
+    ThreadPool pool(4);
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto record = [&](size_t) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        std::lock_guard lock(mutex);
+        threads.insert(std::this_thread::get_id());
+    };
+    pool.ParallelFor(64, record, 2);
+    REQUIRE(threads.size() <= 2);
+    threads.clear();
+    pool.ParallelFor(64, record, 1);
+    REQUIRE(threads == std::set<std::thread::id>{std::this_thread::get_id()});
+}
+
+TEST_CASE("Nested and failing loops") {
+    ThreadPool pool(3);
+    std::atomic<size_t> count = 0;
+    pool.ParallelFor(8, [&](size_t) { pool.ParallelFor(8, [&count](size_t) { ++count; }); });
+    REQUIRE(count == 64);
+
+    REQUIRE_THROWS_AS(pool.ParallelFor(16,
+                                       [](size_t i) {
+                                           if (i == 11) {
+                                               throw std::runtime_error{"Task failed"};
+                                           }
+                                       }),
+                      std::runtime_error);
+    count = 0;
+    pool.ParallelFor(10, [&count](size_t) { ++count; });
+    REQUIRE(count == 10);
+}